@@ -0,0 +1,122 @@
+#include "ahocorasick.h"
+
+#include <algorithm>
+#include <iterator>
+#include <queue>
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+AhoCorasick::AhoCorasick(const std::vector<std::string> &patterns)
+{
+    for (const auto &pattern : patterns)
+        add(pattern);
+    build();
+}
+
+size_t AhoCorasick::add(const std::string_view pattern)
+{
+    m_patterns.emplace_back(pattern);
+    return m_patterns.size() - 1;
+}
+
+/*!
+    Build the trie of the patterns, then turn it into an automaton in
+    breadth-first order: the missing transitions of a state are those of its
+    failure state, which is always shallower and thus already complete.
+ */
+void AhoCorasick::build()
+{
+    std::fill(std::begin(m_symbols), std::end(m_symbols), 0);
+    m_alphabet_size = 1;
+    for (const auto &pattern : m_patterns) {
+        for (char c : pattern) {
+            auto &symbol = m_symbols[static_cast<unsigned char>(c)];
+            if (symbol == 0)
+                symbol = static_cast<uint16_t>(m_alphabet_size++);
+        }
+    }
+
+    // Trie, with 0 meaning "no child" since the root is nobody's child.
+    m_transitions.assign(m_alphabet_size, 0);
+    m_first_match.assign(1, NO_MATCH);
+    m_next_match.assign(m_patterns.size(), NO_MATCH);
+    for (size_t id = 0; id < m_patterns.size(); id++) {
+        if (m_patterns[id].empty())
+            continue;
+
+        uint32_t state = 0;
+        for (char c : m_patterns[id]) {
+            size_t slot = state * m_alphabet_size + m_symbols[static_cast<unsigned char>(c)];
+            if (m_transitions[slot] == 0) {
+                m_transitions[slot] = static_cast<uint32_t>(m_first_match.size());
+                m_transitions.resize(m_transitions.size() + m_alphabet_size, 0);
+                m_first_match.push_back(NO_MATCH);
+            }
+            state = m_transitions[slot];
+        }
+
+        // Keep equal patterns in id order.
+        uint32_t *last = &m_first_match[state];
+        while (*last != NO_MATCH)
+            last = &m_next_match[*last];
+        *last = static_cast<uint32_t>(id);
+    }
+
+    size_t n_states = m_first_match.size();
+    std::vector<uint32_t> failure(n_states, 0);
+    m_dict_links.assign(n_states, 0);
+
+    std::queue<uint32_t> queue;
+    for (size_t symbol = 0; symbol < m_alphabet_size; symbol++) {
+        if (m_transitions[symbol] != 0)
+            queue.push(m_transitions[symbol]);
+    }
+
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop();
+
+        uint32_t *row = &m_transitions[state * m_alphabet_size];
+        const uint32_t *fail_row = &m_transitions[failure[state] * m_alphabet_size];
+        for (size_t symbol = 0; symbol < m_alphabet_size; symbol++) {
+            if (row[symbol] == 0) {
+                row[symbol] = fail_row[symbol];
+                continue;
+            }
+
+            uint32_t child = row[symbol];
+            uint32_t fail = fail_row[symbol];
+            failure[child] = fail;
+            m_dict_links[child] = m_first_match[fail] != NO_MATCH ? fail : m_dict_links[fail];
+            queue.push(child);
+        }
+    }
+}
+
+/*!
+    Return the number of occurrences in \a text of each pattern, by id.
+ */
+std::vector<size_t> AhoCorasick::count(const std::string_view text) const
+{
+    std::vector<size_t> counts(m_patterns.size(), 0);
+    search(text, [&counts](const size_t id, const size_t) {
+        counts[id]++;
+    });
+
+    return counts;
+}
+
+/*!
+    Return the sorted starting positions in \a text of each pattern, by id.
+ */
+std::vector<std::vector<size_t>> AhoCorasick::index(const std::string_view text) const
+{
+    std::vector<std::vector<size_t>> positions(m_patterns.size());
+    search(text, [&positions](const size_t id, const size_t position) {
+        positions[id].push_back(position);
+    });
+
+    return positions;
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
@@ -0,0 +1,85 @@
+#ifndef LIB_AHOCORASICK_H
+#define LIB_AHOCORASICK_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "global.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    \brief Aho-Corasick automaton matching many patterns in one pass.
+
+    Patterns are added with add() and compiled by build() into a
+    deterministic automaton: each state has one transition per byte of the
+    pattern alphabet, so every byte of the text costs a single table lookup
+    however many patterns there are. Matches are reported by following
+    dictionary suffix links, so overlapping and nested occurrences are all
+    found. Bytes are compared as they are, like PatternIndex() does.
+ */
+class AhoCorasick {
+
+public:
+    AhoCorasick() { build(); }
+    explicit AhoCorasick(const std::vector<std::string> &patterns);
+
+    /*!
+        Add \a pattern and return its id, its rank among added patterns.
+        Empty patterns never match. build() must be called again after
+        adding patterns.
+     */
+    size_t add(const std::string_view pattern);
+    void build();
+
+    size_t size() const noexcept { return m_patterns.size(); }
+    bool empty() const noexcept { return m_patterns.empty(); }
+    const std::string &pattern(const size_t id) const { return m_patterns[id]; }
+
+    /*!
+        Call \a fn(id, position) for every occurrence in \a text of every
+        pattern, where \a position is its starting index. Occurrences are
+        reported by increasing end position.
+     */
+    template <typename Fn>
+    void search(const std::string_view text, Fn fn) const
+    {
+        uint32_t state = 0;
+        for (size_t i = 0; i < text.length(); i++) {
+            auto symbol = m_symbols[static_cast<unsigned char>(text[i])];
+            state = m_transitions[state * m_alphabet_size + symbol];
+
+            uint32_t out = m_first_match[state] != NO_MATCH ? state : m_dict_links[state];
+            for (; out != 0; out = m_dict_links[out]) {
+                for (uint32_t id = m_first_match[out]; id != NO_MATCH; id = m_next_match[id])
+                    fn(static_cast<size_t>(id), i + 1 - m_patterns[id].length());
+            }
+        }
+    }
+
+    std::vector<size_t> count(const std::string_view text) const;
+    std::vector<std::vector<size_t>> index(const std::string_view text) const;
+
+private:
+    static constexpr uint32_t NO_MATCH = UINT32_MAX;
+
+    std::vector<std::string> m_patterns;
+
+    // Byte to symbol, symbol 0 standing for bytes absent from all patterns.
+    uint16_t m_symbols[256] = {};
+    size_t m_alphabet_size = 1;
+
+    std::vector<uint32_t> m_transitions;
+    // First pattern ending at each state, other patterns equal to it
+    // chained by m_next_match.
+    std::vector<uint32_t> m_first_match;
+    std::vector<uint32_t> m_next_match;
+    // Nearest proper suffix state at which a pattern ends, 0 if none.
+    std::vector<uint32_t> m_dict_links;
+};
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_AHOCORASICK_H
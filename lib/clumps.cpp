@@ -0,0 +1,195 @@
+#include "clumps.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+
+#include "counter.h"
+#include "kmer.h"
+#include "parallel.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+template <typename Code>
+struct CodedInterval {
+    Code code;
+    size_t begin;
+    size_t end;
+};
+
+/*!
+    Slide a window of \a window_length bytes over \a genome and return the
+    clump intervals of every k-mer, shifted by \a offset. \a genome must be
+    shorter than 4 GiB.
+
+    Each distinct k-mer has one State in a FlatHashMap: its count in the
+    window and its first and last occurrence in the window. Occurrences of
+    a k-mer in the window are chained by \c next, a ring indexed by k-mer
+    start modulo the number of starts in a window, so the first occurrence
+    is known in O(1) when one leaves.
+
+    When the count of a k-mer reaches \a times, its occurrences from the
+    first one in the window form a clump. A clump overlapping the open
+    interval of the k-mer extends it, otherwise the interval is closed and
+    a new one opened, so intervals come out as the union of all clumps.
+    Open intervals are kept apart, as few k-mers form clumps, which keeps
+    the State of every k-mer small.
+ */
+template <typename Rolling>
+static std::vector<CodedInterval<decltype(Rolling(1).forward())>> ScanClumps(
+    const std::string_view genome, const size_t offset, int k, int window_length, int times)
+{
+    typedef decltype(Rolling(1).forward()) code_type;
+
+    struct State {
+        uint32_t count = 0;
+        uint32_t first = 0;
+        uint32_t last = 0;
+    };
+
+    struct Interval {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<CodedInterval<code_type>> found;
+    FlatHashMap<code_type, State> states;
+    FlatHashMap<code_type, Interval> open;
+
+    // Number of k-mer starts in a window.
+    size_t span = window_length - k + 1;
+    std::vector<uint32_t> next(span);
+    Rolling head(k), tail(k);
+    for (size_t i = 0; i < genome.length(); i++) {
+        if (i >= span && tail.push(genome[i - span]) && tail.ready()) {
+            // The leaving k-mer is the first occurrence of its code.
+            size_t q = i - span + 1 - k;
+            State &state = states[tail.forward()];
+            if (--state.count > 0)
+                state.first = next[q % span];
+        }
+
+        if (!head.push(genome[i]) || !head.ready())
+            continue;
+
+        uint32_t p = i + 1 - k;
+        State &state = states[head.forward()];
+        if (state.count++ == 0)
+            state.first = p;
+        else
+            next[state.last % span] = p;
+        state.last = p;
+
+        if (state.count < static_cast<uint32_t>(times))
+            continue;
+
+        Interval &interval = open[head.forward()];
+        if (interval.end <= state.first) {
+            // A new interval has end 0.
+            if (interval.end != 0)
+                found.push_back({head.forward(), offset + interval.begin, offset + interval.end});
+            interval.begin = state.first;
+        }
+        interval.end = p + k;
+    }
+
+    open.forEach([&](const code_type &code, const Interval &interval) {
+        found.push_back({code, offset + interval.begin, offset + interval.end});
+    });
+
+    return found;
+}
+
+template <typename Rolling>
+static std::vector<ClumpInterval> FindClumpIntervalsPacked(const std::string_view genome,
+    int k, int window_length, int times, const int threads)
+{
+    typedef CodedInterval<decltype(Rolling(1).forward())> Coded;
+
+    // Shards overlap by a window, so each one should be long enough for
+    // the overlap to stay a small share of the work.
+    const size_t MIN_SHARD_LENGTH = std::max<size_t>(1 << 16, 16 * window_length);
+
+    // Positions within a shard are 32-bit.
+    const size_t MAX_SHARD_LENGTH = size_t(1) << 31;
+
+    size_t n = std::min<size_t>(utils::ThreadCount(threads), genome.length() / MIN_SHARD_LENGTH);
+    n = std::max(n, genome.length() / MAX_SHARD_LENGTH + 1);
+    auto shards = utils::SplitShards(genome, n, window_length - 1);
+
+    std::vector<std::vector<Coded>> found(shards.size());
+    utils::ParallelFor(shards.size(), threads, [&](const size_t i) {
+        size_t offset = shards[i].data() - genome.data();
+        found[i] = ScanClumps<Rolling>(shards[i], offset, k, window_length, times);
+    });
+
+    std::vector<Coded> coded = std::move(found[0]);
+    for (size_t i = 1; i < found.size(); i++)
+        coded.insert(coded.end(), found[i].begin(), found[i].end());
+
+    // Every window lies in one shard, so each clump is found by at least
+    // one of them, but a clump interval crossing a shard boundary comes in
+    // pieces which are merged here.
+    if (found.size() > 1) {
+        std::sort(coded.begin(), coded.end(), [](const Coded &a, const Coded &b) {
+            return a.code < b.code || (a.code == b.code && a.begin < b.begin);
+        });
+
+        size_t merged = 0;
+        for (size_t i = 1; i < coded.size(); i++) {
+            Coded &last = coded[merged];
+            if (coded[i].code == last.code && coded[i].begin < last.end)
+                last.end = std::max(last.end, coded[i].end);
+            else
+                coded[++merged] = coded[i];
+        }
+        coded.resize(coded.empty() ? 0 : merged + 1);
+    }
+
+    std::vector<ClumpInterval> clumps;
+    clumps.reserve(coded.size());
+    for (const auto &c : coded)
+        clumps.push_back({SpellKmer(c.code, k), c.begin, c.end});
+
+    std::sort(clumps.begin(), clumps.end(), [](const ClumpInterval &a, const ClumpInterval &b) {
+        return std::tie(a.begin, a.end, a.kmer) < std::tie(b.begin, b.end, b.kmer);
+    });
+
+    return clumps;
+}
+
+/*!
+    \brief Find the regions of a genome where k-mers form clumps.
+
+    A k-mer forms a clump if it appears at least \a times within an
+    interval of \a genome of length \a window_length. Each k-mer gets the
+    union of the spans of its clumps, one ClumpInterval per connected
+    region, and the intervals are sorted by position. FindClumps() returns
+    the distinct k-mers of these intervals.
+
+    k-mers are encoded by rolling 2-bit codes and counted in a hash table
+    sized to the distinct k-mers, so memory does not grow with 4^k nor with
+    \a window_length beyond one index per k-mer start. k-mers containing a
+    non-ACGT byte are skipped, and lower and upper case are counted
+    together. With several \a threads, segments of \a genome overlapping
+    by a window are scanned in parallel, with the same result.
+
+    \a k must be at most 64.
+ */
+std::vector<ClumpInterval> FindClumpIntervals(const std::string_view genome,
+    int k, int window_length, int times, const int threads)
+{
+    if (k > RollingKmer128::MAX_K)
+        throw std::runtime_error("The length of k-mer is out of range.");
+
+    if (k <= 0 || window_length < k || genome.length() < static_cast<size_t>(window_length) || times <= 0)
+        return std::vector<ClumpInterval>();
+
+    if (k <= RollingKmer::MAX_K)
+        return FindClumpIntervalsPacked<RollingKmer>(genome, k, window_length, times, threads);
+    else
+        return FindClumpIntervalsPacked<RollingKmer128>(genome, k, window_length, times, threads);
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
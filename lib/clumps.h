@@ -0,0 +1,36 @@
+#ifndef LIB_CLUMPS_H
+#define LIB_CLUMPS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "global.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    \brief Region of a genome where a k-mer forms clumps.
+
+    [\c begin, \c end) runs from the start of the first to the end of the
+    last occurrence of \c kmer taking part in a clump. \c kmer is spelled
+    in upper case, as FindClumps() spells it.
+ */
+struct ClumpInterval {
+    std::string kmer;
+    size_t begin = 0;
+    size_t end = 0;
+
+    bool operator==(const ClumpInterval &other) const noexcept
+    {
+        return kmer == other.kmer && begin == other.begin && end == other.end;
+    }
+    bool operator!=(const ClumpInterval &other) const noexcept { return !(*this == other); }
+};
+
+std::vector<ClumpInterval> FindClumpIntervals(const std::string_view genome,
+    int k, int window_length, int times, const int threads = 1);
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_CLUMPS_H
@@ -0,0 +1,180 @@
+#include "counter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    \a expected_kmers is the number of k-mers that will be counted, or 0 if
+    unknown. It helps choosing the backend and sizes the hash table, up to
+    the 4^k distinct k-mers there can be at most.
+ */
+KmerCounter::KmerCounter(const int k, const size_t expected_kmers)
+    : m_k(k),
+      m_dense_mode(preferDense(k, expected_kmers)),
+      m_sparse(m_dense_mode ? 0 : k < 32 ? std::min<size_t>(expected_kmers, size_t(1) << 2*k) : expected_kmers)
+{
+    if (m_dense_mode)
+        m_dense.assign(hash_t(1) << 2*k, 0);
+}
+
+/*!
+    A dense array is used for k up to DENSE_MAX_K (4^12 counters, 64 MiB),
+    unless it would hold 16 times more counters than there are k-mers to
+    count, in which case most of it would stay empty.
+
+    Up to DENSE_LIMIT_K (4^14 counters, 1 GiB), it is still used when the
+    expected k-mers fill an eighth of it: a hash table slot of 16 bytes at
+    most half full costs 32 bytes a k-mer, against 4 bytes a counter.
+ */
+bool KmerCounter::preferDense(const int k, const size_t expected_kmers) noexcept
+{
+    if (k > DENSE_LIMIT_K)
+        return false;
+
+    hash_t cells = hash_t(1) << 2*k;
+    if (k > DENSE_MAX_K)
+        return expected_kmers >= cells / 8;
+    return expected_kmers == 0 || k <= 8 || cells <= 16 * expected_kmers;
+}
+
+uint KmerCounter::max() const
+{
+    uint max = 0;
+    forEach([&max](const hash_t, const uint count) {
+        if (count > max) max = count;
+    });
+
+    return max;
+}
+
+/*!
+    Add the counts of \a other, which must have the same \a k.
+ */
+void KmerCounter::merge(const KmerCounter &other)
+{
+    if (m_dense_mode && other.m_dense_mode) {
+        for (size_t i = 0; i < m_dense.size(); i++)
+            m_dense[i] += other.m_dense[i];
+        return;
+    }
+
+    other.forEach([this](const hash_t code, const uint count) {
+        if (m_dense_mode)
+            m_dense[code] += count;
+        else
+            m_sparse[code] += count;
+    });
+}
+
+// Bits sorted by a pass of RadixSort(): 2048 counters stay in L1.
+static const int RADIX_BITS = 11;
+
+// Below this many keys, std::sort is faster than clearing the counters.
+static const size_t RADIX_MIN_SIZE = 256;
+
+// Below this many keys, they already fit the cache and are not split into
+// buckets first.
+static const size_t RADIX_SPLIT_SIZE = 1 << 16;
+
+/*!
+    Sort the \a n keys at \a in on their \a bits low bits, the others being
+    equal, into \a out, by LSD passes of at most RADIX_BITS bits. \a in is
+    used as the buffer of the passes. A pass whose digit is the same for
+    every key is skipped.
+ */
+static void LsdRadixSort(hash_t *in, hash_t *out, const size_t n, const int bits)
+{
+    if (n < RADIX_MIN_SIZE || bits == 0) {
+        std::memcpy(out, in, n * sizeof(hash_t));
+        if (bits != 0)
+            std::sort(out, out + n);
+        return;
+    }
+
+    int passes = (bits + RADIX_BITS - 1) / RADIX_BITS;
+    int digit = (bits + passes - 1) / passes;
+    hash_t mask = (hash_t(1) << digit) - 1;
+
+    // Each pass run swaps src and dst, so the sorted keys are in src: out
+    // after an odd number of passes, in after an even one. Skipped passes
+    // make the count unknown up front, so the copy below handles both.
+    hash_t *src = in, *dst = out;
+    std::array<size_t, size_t(1) << RADIX_BITS> count;
+    for (int shift = 0; shift < bits; shift += digit) {
+        std::fill(count.begin(), count.begin() + mask + 1, 0);
+        for (size_t i = 0; i < n; i++)
+            count[(src[i] >> shift) & mask]++;
+        if (count[(src[0] >> shift) & mask] == n)
+            continue;
+
+        size_t sum = 0;
+        for (size_t d = 0; d <= mask; d++)
+            sum += std::exchange(count[d], sum);
+        for (size_t i = 0; i < n; i++)
+            dst[count[(src[i] >> shift) & mask]++] = src[i];
+        std::swap(src, dst);
+    }
+
+    if (src != out)
+        std::memcpy(out, src, n * sizeof(hash_t));
+}
+
+/*!
+    \brief Sort \a keys, which must all be below 2^\a bits, by radix.
+
+    k-mer codes are integers of exactly 2k bits, so they are sorted in
+    O(n) passes over the keys instead of O(n log n) comparisons. A first
+    MSD pass on the RADIX_BITS high bits splits the keys into buckets with
+    \a threads threads, each counting and then scattering its own slice of
+    \a keys. Each bucket is then a small independent range that fits the
+    cache better, sorted on the remaining low bits by LSD passes, the
+    buckets being shared out to the threads. An extra buffer of the size
+    of \a keys is used.
+ */
+void RadixSort(std::vector<hash_t> &keys, const int bits, const int threads)
+{
+    const size_t n = keys.size();
+    if (n < RADIX_SPLIT_SIZE) {
+        std::vector<hash_t> sorted(n);
+        LsdRadixSort(keys.data(), sorted.data(), n, bits);
+        keys.swap(sorted);
+        return;
+    }
+
+    const int top_bits = std::min(bits, RADIX_BITS);
+    const int shift = bits - top_bits;
+    const size_t buckets = size_t(1) << top_bits;
+    const size_t slices = std::max<size_t>(1, std::min<size_t>(utils::ThreadCount(threads), n / RADIX_SPLIT_SIZE));
+    auto slice_begin = [n, slices](const size_t i) { return n * i / slices; };
+
+    // offsets[i][b] is where slice i writes its keys of bucket b.
+    std::vector<std::vector<size_t>> offsets(slices, std::vector<size_t>(buckets, 0));
+    utils::ParallelFor(slices, threads, [&](const size_t i) {
+        for (size_t j = slice_begin(i); j < slice_begin(i + 1); j++)
+            offsets[i][keys[j] >> shift]++;
+    });
+
+    std::vector<size_t> starts(buckets + 1);
+    size_t sum = 0;
+    for (size_t b = 0; b < buckets; b++) {
+        starts[b] = sum;
+        for (size_t i = 0; i < slices; i++)
+            sum += std::exchange(offsets[i][b], sum);
+    }
+    starts[buckets] = n;
+
+    std::vector<hash_t> buffer(n);
+    utils::ParallelFor(slices, threads, [&](const size_t i) {
+        for (size_t j = slice_begin(i); j < slice_begin(i + 1); j++)
+            buffer[offsets[i][keys[j] >> shift]++] = keys[j];
+    });
+
+    utils::ParallelFor(buckets, threads, [&](const size_t b) {
+        LsdRadixSort(buffer.data() + starts[b], keys.data() + starts[b], starts[b + 1] - starts[b], shift);
+    });
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
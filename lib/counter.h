@@ -0,0 +1,462 @@
+#ifndef LIB_COUNTER_H
+#define LIB_COUNTER_H
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "global.h"
+#include "kmer.h"
+#include "parallel.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    Scramble the bits of an integer key (the MurmurHash3 finalizer), so
+    that k-mer codes sharing a prefix spread over the whole table.
+ */
+inline uint64_t MixHash(uint64_t key) noexcept
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+template <typename Key>
+struct KeyHash {
+    uint64_t operator()(const Key &key) const noexcept { return MixHash(key); }
+};
+
+template <>
+struct KeyHash<hash128_t> {
+    uint64_t operator()(const hash128_t &key) const noexcept
+    {
+        return MixHash(key.low ^ MixHash(key.high));
+    }
+};
+
+/*!
+    \brief Open-addressing hash map from integer keys to small values.
+
+    All slots live in one flat array and collisions are resolved by linear
+    probing, so a lookup usually touches a single cache line and nothing is
+    allocated per key. The table doubles when half full. Keys are never
+    erased, only cleared all at once.
+ */
+template <typename Key, typename Value, typename Hash = KeyHash<Key>>
+class FlatHashMap {
+
+public:
+    explicit FlatHashMap(const size_t expected = 0)
+    {
+        size_t capacity = 16;
+        while (capacity < 2 * expected)
+            capacity <<= 1;
+        m_slots.resize(capacity);
+    }
+
+    /*!
+        Return the value of \a key, inserting a value-initialized one first
+        if \a key is not in the map.
+     */
+    Value &operator[](const Key &key)
+    {
+        if (2 * (m_size + 1) > m_slots.size())
+            grow();
+
+        Slot &slot = m_slots[probe(key)];
+        if (!slot.used) {
+            slot.key = key;
+            slot.used = true;
+            m_size++;
+        }
+
+        return slot.value;
+    }
+
+    /*!
+        Return the value of \a key, or nullptr if \a key is not in the map.
+     */
+    const Value *find(const Key &key) const noexcept
+    {
+        const Slot &slot = m_slots[probe(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+
+    void clear() noexcept
+    {
+        for (auto &slot : m_slots)
+            slot = Slot();
+        m_size = 0;
+    }
+
+    /*!
+        Call \a fn(key, value) on every key of the map, in no particular order.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (const auto &slot : m_slots) {
+            if (slot.used)
+                fn(slot.key, slot.value);
+        }
+    }
+
+private:
+    struct Slot {
+        Key key{};
+        Value value{};
+        bool used = false;
+    };
+
+    /*!
+        Index of the slot holding \a key, or of the empty slot where it
+        would be inserted.
+     */
+    size_t probe(const Key &key) const noexcept
+    {
+        size_t mask = m_slots.size() - 1;
+        size_t i = Hash()(key) & mask;
+        while (m_slots[i].used && !(m_slots[i].key == key))
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old(m_slots.size() * 2);
+        old.swap(m_slots);
+        for (const auto &slot : old) {
+            if (slot.used)
+                m_slots[probe(slot.key)] = slot;
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    size_t m_size = 0;
+};
+
+/*!
+    \brief FlatHashMap counting integer keys.
+
+    A key whose count drops back to zero keeps its slot until clear(), but
+    is skipped by forEach().
+ */
+template <typename Key, typename Hash = KeyHash<Key>>
+class FlatCounter {
+
+public:
+    explicit FlatCounter(const size_t expected = 0) : m_map(expected) {}
+
+    /*!
+        Return the count of \a key, inserting it with count zero first if
+        it is not in the table.
+     */
+    uint &operator[](const Key &key) { return m_map[key]; }
+
+    uint count(const Key &key) const noexcept
+    {
+        const uint *count = m_map.find(key);
+        return count ? *count : 0;
+    }
+
+    size_t size() const noexcept { return m_map.size(); }
+    bool empty() const noexcept { return m_map.empty(); }
+    void clear() noexcept { m_map.clear(); }
+
+    /*!
+        Call \a fn(key, count) on every key with a non-zero count.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        m_map.forEach([&fn](const Key &key, const uint count) {
+            if (count != 0)
+                fn(key, count);
+        });
+    }
+
+    void merge(const FlatCounter &other)
+    {
+        other.forEach([this](const Key &key, const uint count) {
+            m_map[key] += count;
+        });
+    }
+
+private:
+    FlatHashMap<Key, uint, Hash> m_map;
+};
+
+/*!
+    \brief Count table of k-mer codes which picks its backend from \a k.
+
+    Small \a k use a dense array of 4^k counters indexed by the k-mer code,
+    as FrequencyArray() does. Beyond DENSE_MAX_K, or when the array would
+    be far larger than the number of k-mers to count, a FlatCounter sized
+    to the distinct k-mers is used instead, so memory no longer grows with
+    4^k and any k up to MAX_HASHABLE_LENGTH can be counted. See
+    preferDense() for the exact choice.
+ */
+class KmerCounter {
+
+public:
+    static constexpr int DENSE_MAX_K = 12;
+    static constexpr int DENSE_LIMIT_K = 14;
+
+    explicit KmerCounter(const int k, const size_t expected_kmers = 0);
+
+    static bool preferDense(const int k, const size_t expected_kmers) noexcept;
+
+    int k() const noexcept { return m_k; }
+    bool isDense() const noexcept { return m_dense_mode; }
+
+    /*!
+        Increase the count of \a code by one and return the new count.
+     */
+    uint increment(const hash_t code)
+    {
+        return m_dense_mode ? ++m_dense[code] : ++m_sparse[code];
+    }
+
+    /*!
+        Increase the count of \a code by \a count and return the new count.
+     */
+    uint add(const hash_t code, const uint count)
+    {
+        return m_dense_mode ? m_dense[code] += count : m_sparse[code] += count;
+    }
+
+    void decrement(const hash_t code)
+    {
+        if (m_dense_mode)
+            --m_dense[code];
+        else
+            --m_sparse[code];
+    }
+
+    uint count(const hash_t code) const noexcept
+    {
+        return m_dense_mode ? m_dense[code] : m_sparse.count(code);
+    }
+
+    /*!
+        Call \a fn(code, count) on every k-mer with a non-zero count.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        if (m_dense_mode) {
+            for (size_t i = 0; i < m_dense.size(); i++) {
+                if (m_dense[i] != 0)
+                    fn(hash_t(i), m_dense[i]);
+            }
+        } else {
+            m_sparse.forEach(fn);
+        }
+    }
+
+    uint max() const;
+    void merge(const KmerCounter &other);
+
+private:
+    int m_k;
+    bool m_dense_mode;
+    std::vector<uint> m_dense;
+    FlatCounter<hash_t> m_sparse;
+};
+
+void RadixSort(std::vector<hash_t> &keys, const int bits, const int threads = 1);
+
+/*!
+    \brief Partial selection of the \a n most frequent keys.
+
+    Entries are offered one at a time to add() and only the best \a n are
+    kept, in a heap whose top is the worst of them, so selecting the most
+    frequent k-mers costs O(m log n) for m distinct k-mers and never holds
+    more than \a n entries. A key is only converted to \a Key once it
+    enters the heap. take() returns the entries by decreasing count, and by
+    increasing key among equal counts.
+ */
+template <typename Key>
+class TopCounts {
+
+public:
+    typedef std::pair<Key, uint> Entry;
+
+    explicit TopCounts(const size_t n) : m_n(n) {}
+
+    template <typename K>
+    void add(const K &key, const uint count)
+    {
+        if (m_heap.size() < m_n) {
+            m_heap.emplace_back(Key(key), count);
+            std::push_heap(m_heap.begin(), m_heap.end(), better);
+        } else if (m_n != 0 && (count > m_heap.front().second
+                   || (count == m_heap.front().second && key < m_heap.front().first))) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), better);
+            m_heap.back() = Entry(Key(key), count);
+            std::push_heap(m_heap.begin(), m_heap.end(), better);
+        }
+    }
+
+    std::vector<Entry> take()
+    {
+        std::sort_heap(m_heap.begin(), m_heap.end(), better);
+        return std::move(m_heap);
+    }
+
+private:
+    static bool better(const Entry &a, const Entry &b)
+    {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    }
+
+    size_t m_n;
+    std::vector<Entry> m_heap;
+};
+
+/*!
+    \brief Frequency table of the k-mers of a text keyed by their packed code.
+
+    Counting a k-mer costs a rolling update of its code and a probe in a
+    FlatHashMap, without creating a string per k-mer. \a Rolling is the
+    encoder: RollingKmer packs k-mers up to 32 bases into a hash_t, and
+    RollingKmer128 up to 64 bases into a hash128_t.
+
+    forEach() spells each distinct k-mer out of its code, in upper case.
+    k-mers containing a non-ACGT byte are not counted, and lower and upper
+    case spellings of a k-mer are counted together.
+ */
+template <typename Rolling>
+class BasicKmerTable {
+
+public:
+    typedef decltype(Rolling(1).forward()) code_type;
+
+    static constexpr int MAX_K = Rolling::MAX_K;
+
+    /*!
+        Count the k-mers of \a text. With several \a threads, shards of
+        \a text are counted into their own table and merged in text order.
+     */
+    BasicKmerTable(const std::string_view text, const int k, const int threads = 1)
+        : m_k(k)
+    {
+        if (k <= 0 || k > MAX_K)
+            throw std::runtime_error("The length of k-mer is out of range.");
+
+        auto shards = utils::SplitShards(text, utils::ThreadCount(threads), k - 1);
+        if (shards.empty())
+            return;
+
+        std::vector<Map> tables(shards.size());
+        utils::ParallelFor(shards.size(), threads, [&](const size_t i) {
+            tables[i] = countShard(shards[i]);
+        });
+
+        m_table = std::move(tables[0]);
+        for (size_t i = 1; i < tables.size(); i++)
+            m_table.merge(tables[i]);
+    }
+
+    int k() const noexcept { return m_k; }
+
+    /*!
+        Number of distinct k-mers.
+     */
+    size_t size() const noexcept { return m_table.size(); }
+    bool empty() const noexcept { return m_table.empty(); }
+
+    /*!
+        Return the count of \a kmer, or 0 if it is not a k-mer of ACGT bases.
+     */
+    uint count(const std::string_view kmer) const noexcept
+    {
+        code_type code;
+        if (!encode(kmer, code))
+            return 0;
+
+        return m_table.count(code);
+    }
+
+    uint max() const noexcept
+    {
+        uint max = 0;
+        m_table.forEach([&max](const code_type &, const uint count) {
+            if (count > max) max = count;
+        });
+        return max;
+    }
+
+    /*!
+        Call \a fn(kmer, count) on every distinct k-mer, where \a kmer is
+        the std::string spelled from its code.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        m_table.forEach([&](const code_type &code, const uint count) {
+            fn(SpellKmer(code, m_k), count);
+        });
+    }
+
+    /*!
+        Call \a fn(code, count) on every distinct k-mer.
+     */
+    template <typename Fn>
+    void forEachCode(Fn fn) const
+    {
+        m_table.forEach(fn);
+    }
+
+private:
+    typedef FlatCounter<code_type> Map;
+
+    Map countShard(const std::string_view shard) const
+    {
+        Map table;
+        Rolling rolling(m_k);
+        for (char base : shard) {
+            if (rolling.push(base) && rolling.ready())
+                ++table[rolling.forward()];
+        }
+
+        return table;
+    }
+
+    bool encode(const std::string_view kmer, code_type &code) const noexcept
+    {
+        if (kmer.length() != static_cast<size_t>(m_k))
+            return false;
+
+        Rolling rolling(m_k);
+        for (char base : kmer) {
+            if (!rolling.push(base))
+                return false;
+        }
+
+        code = rolling.forward();
+        return true;
+    }
+
+    int m_k;
+    Map m_table;
+};
+
+typedef BasicKmerTable<RollingKmer> KmerTable;
+typedef BasicKmerTable<RollingKmer128> KmerTable128;
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_COUNTER_H
@@ -5,6 +5,17 @@
 #include <string>
 #include <fstream>
 #include <streambuf>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BIOUTILS_HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 BIOUTILS_BEGIN_SUB_NAMESPACE(IO)
 
@@ -47,6 +58,9 @@ read_file(const char *filename)
     return buffer;
 }
 
+// Inputs are read in blocks of this size when they can not be mapped.
+static const size_t READ_CHUNK_SIZE = 1 << 20;
+
 /**
  * @brief Read whole stdin text stream into memory.
  * 
@@ -55,17 +69,15 @@ read_file(const char *filename)
 char *
 read_stdin()
 {
-    size_t cap = 4096;
+    size_t cap = READ_CHUNK_SIZE;
     size_t len = 0; 
 
     char *buffer = (char *)malloc(cap * sizeof (char));
-    int c;
+    size_t n;
 
-    while ((c = fgetc(stdin)) != EOF)
+    while ((n = fread(buffer + len, 1, cap - len, stdin)) > 0)
         {
-            buffer[len] = c;
-
-            if (++len == cap)
+            if ((len += n) == cap)
                 // Make the output buffer twice its current size
                 buffer = (char *)realloc(buffer, (cap *= 2) * sizeof (char));
         }
@@ -80,13 +92,147 @@ read_stdin()
 
 std::string read_input(const std::string &argument)
 {
+    InputBuffer input(argument);
+    return std::string(input.view());
+}
+
+/*!
+    Open \a argument, which is either a file name or \c "-" for stdin.
+
+    Throws std::runtime_error if the input can not be opened or read.
+ */
+InputBuffer::InputBuffer(const std::string &argument)
+{
+#ifdef BIOUTILS_HAVE_MMAP
+    int fd = STDIN_FILENO;
+    if (argument != "-") {
+        fd = open(argument.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw std::runtime_error("Can not open file: " + argument);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t length = static_cast<size_t>(st.st_size);
+        void *addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            madvise(addr, length, MADV_SEQUENTIAL);
+            m_mapped = static_cast<const char *>(addr);
+            m_mapped_length = length;
+            m_size = length;
+        }
+    }
+
+    if (!m_mapped) {
+        // Pipes and terminals can not be mapped, so read them chunk by chunk.
+        ssize_t n;
+        size_t len = 0;
+        do {
+            m_buffer.resize(len + READ_CHUNK_SIZE);
+            n = read(fd, &m_buffer[len], READ_CHUNK_SIZE);
+            if (n > 0) len += n;
+        } while (n > 0);
+        m_buffer.resize(len);
+        m_size = len;
+
+        if (n == -1) {
+            if (fd != STDIN_FILENO) close(fd);
+            throw std::runtime_error("Can not read input: " + argument);
+        }
+    }
+
+    if (fd != STDIN_FILENO)
+        close(fd);
+#else
     if (argument == "-") {
-        return read_stdin();
+        char *text = read_stdin();
+        m_buffer = text;
+        free(text);
     } else {
-        return read_file(argument);
+        std::ifstream file(argument, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("Can not open file: " + argument);
+        m_buffer.assign(std::istreambuf_iterator<char>(file),
+                        std::istreambuf_iterator<char>());
     }
+    m_size = m_buffer.size();
+#endif
 }
 
+InputBuffer::~InputBuffer()
+{
+    release();
+}
+
+InputBuffer::InputBuffer(InputBuffer &&other) noexcept
+    : m_mapped(std::exchange(other.m_mapped, nullptr)),
+      m_mapped_length(std::exchange(other.m_mapped_length, 0)),
+      m_buffer(std::move(other.m_buffer)),
+      m_size(std::exchange(other.m_size, 0))
+{
+
+}
+
+InputBuffer &InputBuffer::operator=(InputBuffer &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_mapped = std::exchange(other.m_mapped, nullptr);
+        m_mapped_length = std::exchange(other.m_mapped_length, 0);
+        m_buffer = std::move(other.m_buffer);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    return *this;
+}
+
+void InputBuffer::release() noexcept
+{
+#ifdef BIOUTILS_HAVE_MMAP
+    if (m_mapped)
+        munmap(const_cast<char *>(m_mapped), m_mapped_length);
+#endif
+    m_mapped = nullptr;
+    m_mapped_length = 0;
+}
+
+const char *InputBuffer::data() const noexcept
+{
+    return m_mapped ? m_mapped : m_buffer.data();
+}
+
+/*!
+    Remove all '\n' and '\r' from the content in a single pass and return
+    the compacted view.
+
+    An input without line breaks stays a zero-copy view of the page cache.
+    Otherwise a mapped input is compacted into an owned buffer and unmapped,
+    as writing to the mapping would copy nearly every page of it anyway.
+ */
+std::string_view InputBuffer::removeLineBreaks()
+{
+    auto is_break = [](const char c) { return c == '\n' || c == '\r'; };
+
+    if (m_mapped) {
+        const char *end = m_mapped + m_size;
+        const char *first = std::find_if(m_mapped, end, is_break);
+        if (first == end)
+            return view();
+
+        m_buffer.resize(m_size);
+        char *out = std::copy(m_mapped, first, &m_buffer[0]);
+        out = std::remove_copy_if(first, end, out, is_break);
+        m_buffer.resize(out - m_buffer.data());
+        m_size = m_buffer.size();
+        release();
+        return view();
+    }
+
+    auto last = std::remove_if(m_buffer.begin(), m_buffer.begin() + m_size, is_break);
+    m_buffer.erase(last, m_buffer.end());
+    m_size = m_buffer.size();
+    return view();
+}
 
 BIOUTILS_END_SUB_NAMESPACE(IO)
 
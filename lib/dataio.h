@@ -2,6 +2,7 @@
 #define DATAIO_H
 
 #include <string>
+#include <string_view>
 
 #include "global.h"
 
@@ -12,6 +13,48 @@ char *read_file(const char *);
 char *read_stdin();
 std::string read_input(const std::string &argument);
 
+/*!
+    \brief Read-only view over the whole content of an input.
+
+    Regular files are memory-mapped, so the bytes handed to the algorithms
+    are the pages of the page cache and no copy of the file is made. Pipes,
+    terminals and stdin (\c "-") can not be mapped and are read in large
+    chunks into an owned buffer instead.
+
+    The mapping is read-only, so its pages stay those of the page cache.
+    removeLineBreaks() keeps the mapping of an input without line breaks
+    and otherwise compacts the content into an owned buffer.
+ */
+class InputBuffer {
+
+public:
+    explicit InputBuffer(const std::string &argument) noexcept(false);
+    ~InputBuffer();
+
+    InputBuffer(const InputBuffer &) = delete;
+    InputBuffer &operator=(const InputBuffer &) = delete;
+    InputBuffer(InputBuffer &&other) noexcept;
+    InputBuffer &operator=(InputBuffer &&other) noexcept;
+
+    const char *data() const noexcept;
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    bool isMapped() const noexcept { return m_mapped != nullptr; }
+
+    std::string_view view() const noexcept { return std::string_view(data(), m_size); }
+    operator std::string_view() const noexcept { return view(); }
+
+    std::string_view removeLineBreaks();
+
+private:
+    void release() noexcept;
+
+    const char *m_mapped = nullptr;
+    size_t m_mapped_length = 0;
+    std::string m_buffer;
+    size_t m_size = 0;
+};
+
 BIOUTILS_END_SUB_NAMESPACE(IO)
 
-#endif //DATAIO_H
\ No newline at end of file
+#endif //DATAIO_H
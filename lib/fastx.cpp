@@ -0,0 +1,240 @@
+#include "fastx.h"
+
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(IO)
+
+// Streams are read in blocks of this size.
+static const size_t STREAM_CHUNK_SIZE = 1 << 20;
+
+void SequenceRecord::clear() noexcept
+{
+    // clear() keeps the capacity, so buffers are reused by the next record.
+    name.clear();
+    comment.clear();
+    sequence.clear();
+    quality.clear();
+}
+
+/*!
+    Open \a argument, which is either a file name or \c "-" for stdin.
+ */
+FastxReader::FastxReader(const std::string &argument)
+{
+    std::error_code ec;
+    if (argument != "-" && std::filesystem::is_regular_file(argument, ec)) {
+        m_input = std::make_unique<InputBuffer>(argument);
+        m_begin = m_input->data();
+        m_end = m_begin + m_input->size();
+    } else if (argument == "-") {
+        m_file = stdin;
+    } else {
+        m_file = fopen(argument.c_str(), "rb");
+        if (!m_file)
+            throw std::runtime_error("Can not open file: " + argument);
+    }
+}
+
+FastxReader::~FastxReader()
+{
+    if (m_file && m_file != stdin)
+        fclose(m_file);
+}
+
+/*!
+    Read the next chunk of a stream into the buffer. Mapped inputs are
+    already complete, so there is nothing more to read.
+ */
+bool FastxReader::fill()
+{
+    if (!m_file)
+        return false;
+
+    m_buffer.resize(STREAM_CHUNK_SIZE);
+    size_t n = fread(&m_buffer[0], 1, m_buffer.size(), m_file);
+    m_begin = m_buffer.data();
+    m_end = m_begin + n;
+
+    return n > 0;
+}
+
+int FastxReader::peek()
+{
+    if (m_begin == m_end && !fill())
+        return EOF;
+
+    return static_cast<unsigned char>(*m_begin);
+}
+
+/*!
+    Pass the next line without its line break to \a fn(begin, end), in one
+    piece or, when it spans several chunks of a stream, in several pieces
+    as they sit in the read buffer. memchr() finds line breaks with
+    word-at-a-time or vector instructions, so each piece is handed out in
+    one go. A '\r' ending a piece is held back until it is known whether
+    it ends the line.
+
+    Return false if there is nothing left to read.
+ */
+template <typename Fn>
+bool FastxReader::readLine(Fn fn)
+{
+    static const char CARRIAGE_RETURN = '\r';
+
+    if (peek() == EOF)
+        return false;
+
+    bool carriage = false;
+    while (m_begin != m_end || fill()) {
+        auto nl = static_cast<const char *>(
+            memchr(m_begin, '\n', m_end - m_begin));
+        const char *end = nl ? nl : m_end;
+
+        if (carriage && end != m_begin)
+            fn(&CARRIAGE_RETURN, &CARRIAGE_RETURN + 1);
+        carriage = end != m_begin && end[-1] == '\r';
+        if (carriage)
+            --end;
+        if (end != m_begin)
+            fn(m_begin, end);
+
+        if (nl) {
+            m_begin = nl + 1;
+            break;
+        }
+        m_begin = m_end;
+    }
+
+    return true;
+}
+
+/*!
+    Append the next line to \a out without its line break.
+
+    Return false if there is nothing left to read.
+ */
+bool FastxReader::appendLine(std::string &out)
+{
+    return readLine([&out](const char *begin, const char *end) {
+        out.append(begin, end);
+    });
+}
+
+void FastxReader::skipLine()
+{
+    while (m_begin != m_end || fill()) {
+        auto nl = static_cast<const char *>(
+            memchr(m_begin, '\n', m_end - m_begin));
+        if (nl) {
+            m_begin = nl + 1;
+            return;
+        }
+        m_begin = m_end;
+    }
+}
+
+void FastxReader::readHeader(SequenceRecord &record)
+{
+    // Skip the '>' or '@'
+    ++m_begin;
+    appendLine(record.name);
+
+    auto space = record.name.find_first_of(" \t");
+    if (space != std::string::npos) {
+        record.comment.assign(record.name, space + 1, std::string::npos);
+        record.name.resize(space);
+    }
+}
+
+/*!
+    Read the header of the next record into \a record and hand its
+    sequence lines to \a sink(begin, end). The quality of a FASTQ record
+    is stored only if \a keep_quality is set.
+ */
+template <typename Sink>
+bool FastxReader::readRecord(SequenceRecord &record, Sink sink, const bool keep_quality)
+{
+    record.clear();
+
+    size_t length = 0;
+    auto sequence = [&](const char *begin, const char *end) {
+        length += end - begin;
+        sink(begin, end);
+    };
+
+    size_t quality_length = 0;
+    auto quality = [&](const char *begin, const char *end) {
+        quality_length += end - begin;
+        if (keep_quality)
+            record.quality.append(begin, end);
+    };
+
+    // Skip blank lines between records.
+    int c;
+    while ((c = peek()) == '\n' || c == '\r')
+        ++m_begin;
+
+    switch (c)
+    {
+    case EOF:
+        return false;
+    case '>':
+        readHeader(record);
+        while ((c = peek()) != EOF && c != '>')
+            readLine(sequence);
+        break;
+    case '@':
+        readHeader(record);
+        while ((c = peek()) != EOF && c != '+')
+            readLine(sequence);
+
+        // The separator line may repeat the name, it's ignored.
+        if (c == EOF)
+            throw std::runtime_error("Truncated FASTQ record: " + record.name);
+        skipLine();
+
+        while (quality_length < length && readLine(quality))
+            ;
+        if (quality_length != length)
+            throw std::runtime_error(
+                "Length of quality does not match sequence in FASTQ record: " + record.name);
+        break;
+    default:
+        // Plain sequence without header, every line belongs to one record.
+        while (readLine(sequence))
+            ;
+        break;
+    }
+
+    return true;
+}
+
+/*!
+    Read the next record into \a record. Return false when the input is
+    exhausted.
+
+    Throws std::runtime_error on a truncated FASTQ record.
+ */
+bool FastxReader::next(SequenceRecord &record)
+{
+    return readRecord(record, [&record](const char *begin, const char *end) {
+        record.sequence.append(begin, end);
+    }, true);
+}
+
+/*!
+    Read the next record like next(), but hand its sequence to \a sequence
+    in pieces as it is read, without line breaks, rather than storing it.
+    \c record.sequence and \c record.quality stay empty, so memory does
+    not grow with the length of the record.
+ */
+bool FastxReader::next(SequenceRecord &record, const std::function<void(std::string_view)> &sequence)
+{
+    return readRecord(record, [&sequence](const char *begin, const char *end) {
+        sequence(std::string_view(begin, end - begin));
+    }, false);
+}
+
+BIOUTILS_END_SUB_NAMESPACE(IO)
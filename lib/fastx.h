@@ -0,0 +1,86 @@
+#ifndef LIB_FASTX_H
+#define LIB_FASTX_H
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "global.h"
+#include "dataio.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(IO)
+
+/*!
+    \brief A sequence record of FASTA/FASTQ file.
+
+    \a name is the identifier after '>' or '@' up to the first whitespace and
+    \a comment is the rest of the header line. \a quality is empty for FASTA
+    records. Input without any header is read as a single record with empty
+    \a name.
+ */
+struct SequenceRecord {
+    std::string name;
+    std::string comment;
+    std::string sequence;
+    std::string quality;
+
+    void clear() noexcept;
+};
+
+/*!
+    \brief Streaming reader of FASTA/FASTQ records.
+
+    Records are yielded one at a time into a caller-provided SequenceRecord
+    whose buffers are reused between records, so only the current record
+    is held in memory. Line breaks are dropped while copying the lines out
+    of the read buffer, which is the only copy made of the sequence.
+
+    Regular files are memory-mapped by InputBuffer; pipes and stdin (\c "-")
+    are read in fixed-size chunks.
+
+    \code
+    FastxReader reader(file_name);
+    SequenceRecord record;
+    while (reader.next(record))
+        process(record.sequence);
+    \endcode
+
+    Records too large to hold, such as whole chromosomes, can be read
+    with a callback which is handed the sequence piece by piece instead.
+ */
+class FastxReader {
+
+public:
+    explicit FastxReader(const std::string &argument) noexcept(false);
+    ~FastxReader();
+
+    FastxReader(const FastxReader &) = delete;
+    FastxReader &operator=(const FastxReader &) = delete;
+
+    bool next(SequenceRecord &record) noexcept(false);
+    bool next(SequenceRecord &record,
+        const std::function<void(std::string_view)> &sequence) noexcept(false);
+
+private:
+    bool fill();
+    int peek();
+    template <typename Fn>
+    bool readLine(Fn fn);
+    bool appendLine(std::string &out);
+    void skipLine();
+    void readHeader(SequenceRecord &record);
+    template <typename Sink>
+    bool readRecord(SequenceRecord &record, Sink sink, const bool keep_quality);
+
+    std::unique_ptr<InputBuffer> m_input;
+    FILE *m_file = nullptr;
+    std::string m_buffer;
+    const char *m_begin = nullptr;
+    const char *m_end = nullptr;
+};
+
+BIOUTILS_END_SUB_NAMESPACE(IO)
+
+#endif // LIB_FASTX_H
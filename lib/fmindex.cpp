@@ -0,0 +1,475 @@
+#include "fmindex.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "hamming.h"
+#include "kmer.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+static const uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+// Symbols of the indexed text: the end of the sequence sorts first and
+// ambiguous bases last.
+static const uint8_t END_SYMBOL = 0;
+static const uint8_t AMBIGUOUS_SYMBOL = 5;
+static const uint32_t ALPHABET_SIZE = 6;
+
+static const char INDEX_FILE_MAGIC[8] = {'B', 'I', 'O', 'F', 'M', 'I', 'X', '1'};
+
+/*!
+    Set \a bucket to the start, or with \a end the end, of the range of
+    suffixes beginning with each symbol.
+ */
+template <typename Char>
+static void Buckets(const Char *text, const uint32_t n, std::vector<uint32_t> &bucket, const bool end)
+{
+    std::fill(bucket.begin(), bucket.end(), 0);
+    for (uint32_t i = 0; i < n; i++)
+        bucket[text[i]]++;
+
+    uint32_t sum = 0;
+    for (auto &b : bucket) {
+        uint32_t count = b;
+        sum += count;
+        b = end ? sum : sum - count;
+    }
+}
+
+/*!
+    Sort the L-type suffixes from the sorted suffixes already in \a sa,
+    then the S-type suffixes from the L-type ones.
+ */
+template <typename Char>
+static void InduceSort(const Char *text, uint32_t *sa, const uint32_t n,
+    const std::vector<bool> &stype, std::vector<uint32_t> &bucket)
+{
+    Buckets(text, n, bucket, false);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = sa[i];
+        if (j != EMPTY && j > 0 && !stype[j - 1])
+            sa[bucket[text[j - 1]]++] = j - 1;
+    }
+
+    Buckets(text, n, bucket, true);
+    for (uint32_t i = n; i-- > 0; ) {
+        uint32_t j = sa[i];
+        if (j != EMPTY && j > 0 && stype[j - 1])
+            sa[--bucket[text[j - 1]]] = j - 1;
+    }
+}
+
+/*!
+    Build the suffix array of the \a n symbols of \a text, smaller than
+    \a alphabet, into \a sa by SA-IS (Nong, Zhang and Chan, 2009). The
+    last symbol must be 0 and appear nowhere else.
+
+    Suffixes are typed S or L as they are smaller or larger than the next
+    one, and the leftmost S-type suffixes of each run (LMS) are sorted
+    first: by their LMS substrings, induced from a rough placement, then
+    recursively on the string of their names when these are not unique.
+    All other suffixes are then induced from the sorted LMS suffixes.
+ */
+template <typename Char>
+static void SAIS(const Char *text, uint32_t *sa, const uint32_t n, const uint32_t alphabet)
+{
+    if (n == 1) {
+        sa[0] = 0;
+        return;
+    }
+
+    std::vector<bool> stype(n);
+    stype[n - 1] = true;
+    for (uint32_t i = n - 1; i-- > 0; )
+        stype[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && stype[i + 1]);
+
+    auto isLMS = [&stype](const uint32_t i) { return i > 0 && stype[i] && !stype[i - 1]; };
+
+    std::vector<uint32_t> bucket(alphabet);
+    std::fill(sa, sa + n, EMPTY);
+    Buckets(text, n, bucket, true);
+    for (uint32_t i = 1; i < n; i++) {
+        if (isLMS(i))
+            sa[--bucket[text[i]]] = i;
+    }
+    InduceSort(text, sa, n, stype, bucket);
+
+    // Name the sorted LMS substrings, equal substrings getting the same
+    // name. LMS positions are at least 2 apart, so a name is stored at
+    // half its position in the second half of sa.
+    uint32_t n1 = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (isLMS(sa[i]))
+            sa[n1++] = sa[i];
+    }
+    std::fill(sa + n1, sa + n, EMPTY);
+
+    uint32_t names = 0;
+    uint32_t previous = EMPTY;
+    for (uint32_t i = 0; i < n1; i++) {
+        uint32_t position = sa[i];
+        bool same = previous != EMPTY;
+        for (uint32_t d = 0; same; d++) {
+            if (text[position + d] != text[previous + d] || stype[position + d] != stype[previous + d]) {
+                same = false;
+            } else if (d > 0 && (isLMS(position + d) || isLMS(previous + d))) {
+                same = isLMS(position + d) && isLMS(previous + d);
+                break;
+            }
+        }
+        if (!same)
+            names++;
+        previous = position;
+        sa[n1 + position / 2] = names - 1;
+    }
+
+    std::vector<uint32_t> reduced;
+    reduced.reserve(n1);
+    for (uint32_t i = n1; i < n; i++) {
+        if (sa[i] != EMPTY)
+            reduced.push_back(sa[i]);
+    }
+
+    std::vector<uint32_t> reduced_sa(n1);
+    if (names < n1) {
+        SAIS(reduced.data(), reduced_sa.data(), n1, names);
+    } else {
+        for (uint32_t i = 0; i < n1; i++)
+            reduced_sa[reduced[i]] = i;
+    }
+
+    // Map the sorted reduced suffixes back to LMS positions, reusing
+    // \c reduced for the LMS positions in text order.
+    for (uint32_t i = 1, j = 0; i < n; i++) {
+        if (isLMS(i))
+            reduced[j++] = i;
+    }
+
+    std::fill(sa, sa + n, EMPTY);
+    Buckets(text, n, bucket, true);
+    for (uint32_t i = n1; i-- > 0; ) {
+        uint32_t j = reduced[reduced_sa[i]];
+        sa[--bucket[text[j]]] = j;
+    }
+    InduceSort(text, sa, n, stype, bucket);
+}
+
+/*!
+    \brief Suffix array of \a text.
+
+    The starting positions of the suffixes of \a text in lexicographic
+    order of the bytes, built by SA-IS in linear time. \a text must be
+    shorter than 4 GiB.
+ */
+std::vector<uint32_t> SuffixArray(const std::string_view text)
+{
+    if (text.length() >= EMPTY - 1)
+        throw std::runtime_error("The text is too long for a suffix array.");
+
+    uint32_t n = text.length();
+    std::vector<uint16_t> symbols(n + 1);
+    for (uint32_t i = 0; i < n; i++)
+        symbols[i] = static_cast<unsigned char>(text[i]) + 1;
+    symbols[n] = 0;
+
+    std::vector<uint32_t> sa(n + 1);
+    SAIS(symbols.data(), sa.data(), n + 1, 257);
+
+    // The empty suffix comes first.
+    sa.erase(sa.begin());
+    return sa;
+}
+
+static inline uint64_t LowMask(const int bits) noexcept
+{
+    return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+}
+
+/*!
+    Index \a seq. Ambiguous bases are kept as a symbol of their own, which
+    no pattern matches, so an occurrence never spans one.
+ */
+FMIndex::FMIndex(const PackedSequence &seq)
+{
+    if (seq.size() >= EMPTY - 1)
+        throw std::runtime_error("The sequence is too long to be indexed.");
+
+    m_length = seq.size();
+    uint32_t n = m_length + 1;
+    std::vector<uint8_t> text(n);
+    for (size_t i = 0; i < m_length; i++)
+        text[i] = seq.isAmbiguous(i) ? AMBIGUOUS_SYMBOL : seq.code(i) + 1;
+    text[m_length] = END_SYMBOL;
+
+    std::vector<uint32_t> sa(n);
+    SAIS(text.data(), sa.data(), n, ALPHABET_SIZE);
+
+    // Every position following an ambiguous base is sampled too, as the
+    // walk of locate() can not step over it.
+    auto isSampled = [&text](const uint32_t p) {
+        return p % SAMPLE_RATE == 0 || (text[p - 1] == AMBIGUOUS_SYMBOL && text[p] != AMBIGUOUS_SYMBOL);
+    };
+
+    uint32_t counts[4] = {0, 0, 0, 0};
+    m_blocks.resize(n / 64 + 1);
+    for (size_t i = 0; i < m_blocks.size() * 64; i++) {
+        Block &block = m_blocks[i / 64];
+        int j = i % 64;
+        if (j == 0) {
+            std::copy(counts, counts + 4, block.rank);
+            block.sampled_rank = m_samples.size();
+            block.reserved = 0;
+            block.bases[0] = block.bases[1] = block.special = block.sampled = 0;
+        }
+        if (i >= n)
+            continue;
+
+        uint8_t symbol = sa[i] == 0 ? END_SYMBOL : text[sa[i] - 1];
+        if (symbol == END_SYMBOL || symbol == AMBIGUOUS_SYMBOL) {
+            block.special |= uint64_t(1) << j;
+        } else {
+            block.bases[j / 32] |= uint64_t(symbol - 1) << 2*(j % 32);
+            counts[symbol - 1]++;
+        }
+
+        if (isSampled(sa[i])) {
+            block.sampled |= uint64_t(1) << j;
+            m_samples.push_back(sa[i]);
+        }
+    }
+
+    // The end of the sequence sorts before every base.
+    size_t first = 1;
+    for (int base = 0; base < 4; base++) {
+        m_first[base] = first;
+        first += counts[base];
+    }
+}
+
+FMIndex::FMIndex(const std::string_view seq)
+    : FMIndex(PackedSequence(seq))
+{
+
+}
+
+/*!
+    Number of rows before \a row whose BWT symbol is \a base.
+ */
+size_t FMIndex::rank(const int base, const size_t row) const noexcept
+{
+    const Block &block = m_blocks[row / 64];
+    int r = row % 64;
+    size_t count = block.rank[base];
+    if (r == 0)
+        return count;
+
+    // A symbol matches when both bits of its XOR with the base are zero.
+    const uint64_t pattern = base * 0x5555555555555555ULL;
+    auto matches = [pattern](const uint64_t bases) {
+        uint64_t x = bases ^ pattern;
+        return ~(x | (x >> 1)) & 0x5555555555555555ULL;
+    };
+
+    if (r <= 32) {
+        count += Popcount(matches(block.bases[0]) & LowMask(2*r));
+    } else {
+        count += Popcount(matches(block.bases[0]));
+        count += Popcount(matches(block.bases[1]) & LowMask(2*(r - 32)));
+    }
+
+    // Special symbols are stored as A.
+    if (base == 0)
+        count -= Popcount(block.special & LowMask(r));
+
+    return count;
+}
+
+/*!
+    Position in the sequence of the suffix at \a row, found by stepping
+    back through the BWT to a sampled row.
+ */
+size_t FMIndex::position(size_t row) const noexcept
+{
+    size_t steps = 0;
+    for (;;) {
+        const Block &block = m_blocks[row / 64];
+        int j = row % 64;
+        if ((block.sampled >> j) & 1)
+            return m_samples[block.sampled_rank + Popcount(block.sampled & LowMask(j))] + steps;
+
+        int base = (block.bases[j / 32] >> 2*(j % 32)) & 3;
+        row = m_first[base] + rank(base, row);
+        steps++;
+    }
+}
+
+/*!
+    Narrow the rows [\a lo, \a hi) to the suffixes starting with
+    \a pattern, one base at a time from its end. Return false when there
+    are none.
+ */
+bool FMIndex::backwardSearch(const std::string_view pattern, size_t &lo, size_t &hi) const noexcept
+{
+    if (pattern.empty() || pattern.length() > m_length)
+        return false;
+
+    lo = 0;
+    hi = m_length + 1;
+    for (size_t i = pattern.length(); i-- > 0; ) {
+        int base = BASE_TO_INT[static_cast<unsigned char>(pattern[i])];
+        if (base < 0)
+            return false;
+
+        lo = m_first[base] + rank(base, lo);
+        hi = m_first[base] + rank(base, hi);
+        if (lo >= hi)
+            return false;
+    }
+
+    return true;
+}
+
+/*!
+    Count occurrences of \a pattern in O(m) for a pattern of m bases.
+ */
+size_t FMIndex::count(const std::string_view pattern) const
+{
+    size_t lo, hi;
+    return backwardSearch(pattern, lo, hi) ? hi - lo : 0;
+}
+
+/*!
+    Find all starting positions of \a pattern, in increasing order.
+ */
+std::vector<size_t> FMIndex::locate(const std::string_view pattern) const
+{
+    std::vector<size_t> output;
+    size_t lo, hi;
+    if (!backwardSearch(pattern, lo, hi))
+        return output;
+
+    output.reserve(hi - lo);
+    for (size_t row = lo; row < hi; row++)
+        output.push_back(position(row));
+    std::sort(output.begin(), output.end());
+
+    return output;
+}
+
+template <typename T>
+static void WriteValue(std::ostream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static void ReadValue(std::istream &in, T &value)
+{
+    if (!in.read(reinterpret_cast<char *>(&value), sizeof(T)))
+        throw std::runtime_error("Truncated index file.");
+}
+
+template <typename T>
+static void WriteVector(std::ostream &out, const std::vector<T> &values)
+{
+    WriteValue(out, static_cast<uint64_t>(values.size()));
+    out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+static void ReadVector(std::istream &in, std::vector<T> &values)
+{
+    uint64_t size;
+    ReadValue(in, size);
+    values.resize(size);
+    if (!in.read(reinterpret_cast<char *>(values.data()), size * sizeof(T)))
+        throw std::runtime_error("Truncated index file.");
+}
+
+void FMIndex::save(std::ostream &out) const
+{
+    WriteValue(out, static_cast<uint64_t>(m_length));
+    for (size_t first : m_first)
+        WriteValue(out, static_cast<uint64_t>(first));
+    WriteVector(out, m_blocks);
+    WriteVector(out, m_samples);
+}
+
+void FMIndex::load(std::istream &in)
+{
+    uint64_t length;
+    ReadValue(in, length);
+    m_length = length;
+    for (size_t &first : m_first) {
+        uint64_t value;
+        ReadValue(in, value);
+        first = value;
+    }
+    ReadVector(in, m_blocks);
+    ReadVector(in, m_samples);
+
+    if (m_blocks.size() != (m_length + 1) / 64 + 1 || m_samples.size() > m_length + 1)
+        throw std::runtime_error("Corrupt index file.");
+}
+
+static void WriteString(std::ostream &out, const std::string_view s)
+{
+    WriteValue(out, static_cast<uint64_t>(s.length()));
+    out.write(s.data(), s.length());
+}
+
+static void ReadString(std::istream &in, std::string &s)
+{
+    uint64_t length;
+    ReadValue(in, length);
+    s.resize(length);
+    if (!in.read(s.data(), length))
+        throw std::runtime_error("Truncated index file.");
+}
+
+FMIndexWriter::FMIndexWriter(const std::string &file_name)
+    : m_out(file_name, std::ios::binary)
+{
+    if (!m_out)
+        throw std::runtime_error("Can not open file: " + file_name);
+    m_out.write(INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+}
+
+void FMIndexWriter::write(const std::string_view name, const std::string_view comment, const FMIndex &index)
+{
+    WriteString(m_out, name);
+    WriteString(m_out, comment);
+    index.save(m_out);
+    if (!m_out.flush())
+        throw std::runtime_error("Can not write the index file.");
+}
+
+FMIndexReader::FMIndexReader(const std::string &file_name)
+    : m_in(file_name, std::ios::binary)
+{
+    if (!m_in)
+        throw std::runtime_error("Can not open file: " + file_name);
+
+    char magic[sizeof(INDEX_FILE_MAGIC)];
+    if (!m_in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), INDEX_FILE_MAGIC))
+        throw std::runtime_error("Not an index file: " + file_name);
+}
+
+/*!
+    Read the next record into \a record. Return false at the end of the
+    file.
+ */
+bool FMIndexReader::next(FMIndexRecord &record)
+{
+    if (m_in.peek() == std::char_traits<char>::eof())
+        return false;
+
+    ReadString(m_in, record.name);
+    ReadString(m_in, record.comment);
+    record.index.load(m_in);
+    return true;
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
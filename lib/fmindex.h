@@ -0,0 +1,125 @@
+#ifndef LIB_FMINDEX_H
+#define LIB_FMINDEX_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "global.h"
+#include "packedseq.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+std::vector<uint32_t> SuffixArray(const std::string_view text);
+
+/*!
+    \brief FM-index of a nucleotide sequence for repeated exact searches.
+
+    The suffix array of the sequence is built by SA-IS in linear time, and
+    only its Burrows-Wheeler transform is kept, in blocks of 64 symbols
+    holding 2 bits per base and the rank of each base at the block start,
+    plus the suffix array sampled every SAMPLE_RATE positions. That is
+    about one byte per base.
+
+    count() runs a backward search, O(m) for a pattern of m bases whatever
+    the length of the sequence, and locate() then walks at most
+    SAMPLE_RATE steps per occurrence to a sampled position.
+
+    Like PatternIndex() on a PackedSequence, the search is case-insensitive
+    and an ambiguous base never matches, so a pattern holding anything but
+    ACGT has no occurrence. The sequence must be shorter than 4 Gbp.
+ */
+class FMIndex {
+
+public:
+    static constexpr uint32_t SAMPLE_RATE = 32;
+
+    FMIndex() = default;
+    explicit FMIndex(const PackedSequence &seq);
+    explicit FMIndex(const std::string_view seq);
+
+    size_t size() const noexcept { return m_length; }
+    bool empty() const noexcept { return m_length == 0; }
+
+    size_t count(const std::string_view pattern) const;
+    std::vector<size_t> locate(const std::string_view pattern) const;
+
+    void save(std::ostream &out) const;
+    void load(std::istream &in);
+
+private:
+    // 64 symbols of the BWT. An ambiguous base or the end of the sequence
+    // is flagged in \c special and stored as A in \c bases. Rows whose
+    // suffix array value is sampled are flagged in \c sampled.
+    struct Block {
+        uint32_t rank[4];
+        uint32_t sampled_rank;
+        uint32_t reserved;
+        uint64_t bases[2];
+        uint64_t special;
+        uint64_t sampled;
+    };
+
+    bool backwardSearch(const std::string_view pattern, size_t &lo, size_t &hi) const noexcept;
+    size_t rank(const int base, const size_t row) const noexcept;
+    size_t position(size_t row) const noexcept;
+
+    size_t m_length = 0;
+    size_t m_first[4] = {0, 0, 0, 0};
+    std::vector<Block> m_blocks;
+    std::vector<uint32_t> m_samples;
+};
+
+/*!
+    \brief A record of an index file: the FM-index of one sequence of a
+    FASTA/FASTQ file, with its name and comment.
+ */
+struct FMIndexRecord {
+    std::string name;
+    std::string comment;
+    FMIndex index;
+};
+
+/*!
+    \brief Writer of an index file, one FMIndexRecord after the other.
+
+    Records are written as they are built, so only one FM-index needs to
+    be held at a time. Numbers are stored in the byte order of the host.
+ */
+class FMIndexWriter {
+
+public:
+    explicit FMIndexWriter(const std::string &file_name) noexcept(false);
+
+    void write(const std::string_view name, const std::string_view comment, const FMIndex &index);
+
+private:
+    std::ofstream m_out;
+};
+
+/*!
+    \brief Reader of an index file written by FMIndexWriter.
+
+    \code
+    FMIndexReader reader(file_name);
+    FMIndexRecord record;
+    while (reader.next(record))
+        report(record.name, record.index.locate(pattern));
+    \endcode
+ */
+class FMIndexReader {
+
+public:
+    explicit FMIndexReader(const std::string &file_name) noexcept(false);
+
+    bool next(FMIndexRecord &record) noexcept(false);
+
+private:
+    std::ifstream m_in;
+};
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_FMINDEX_H
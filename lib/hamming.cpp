@@ -0,0 +1,108 @@
+#include "hamming.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BIOUTILS_HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+// Bytes compared between two checks of the limit by the vector kernels.
+static const size_t LIMIT_CHECK_STRIDE = 64;
+
+static size_t CountMismatchesScalar(const char *a, const char *b, const size_t n, const size_t limit) noexcept
+{
+    size_t d = 0;
+    for (size_t i = 0; i < n; i++) {
+        d += a[i] != b[i];
+        if (d > limit)
+            break;
+    }
+
+    return d;
+}
+
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+
+__attribute__((target("sse4.2,popcnt")))
+static size_t CountMismatchesSSE42(const char *a, const char *b, const size_t n, const size_t limit) noexcept
+{
+    size_t d = 0;
+    size_t i = 0;
+    while (i + 16 <= n) {
+        size_t stop = std::min(n - n % 16, i + LIMIT_CHECK_STRIDE);
+        for (; i < stop; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            unsigned int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+            d += 16 - _mm_popcnt_u32(equal);
+        }
+
+        if (d > limit)
+            return d;
+    }
+
+    return d + CountMismatchesScalar(a + i, b + i, n - i, limit - d);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t CountMismatchesAVX2(const char *a, const char *b, const size_t n, const size_t limit) noexcept
+{
+    size_t d = 0;
+    size_t i = 0;
+    while (i + 32 <= n) {
+        size_t stop = std::min(n - n % 32, i + LIMIT_CHECK_STRIDE);
+        for (; i < stop; i += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            unsigned int equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+            d += 32 - _mm_popcnt_u32(equal);
+        }
+
+        if (d > limit)
+            return d;
+    }
+
+    return d + CountMismatchesScalar(a + i, b + i, n - i, limit - d);
+}
+
+#endif // BIOUTILS_HAVE_X86_KERNELS
+
+typedef size_t (*MismatchKernelFuncPtr)(const char *, const char *, const size_t, const size_t);
+
+struct Kernel {
+    MismatchKernelFuncPtr fun;
+    const char *name;
+};
+
+static Kernel SelectKernel() noexcept
+{
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {CountMismatchesAVX2, "avx2"};
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"))
+        return {CountMismatchesSSE42, "sse4.2"};
+#endif
+    return {CountMismatchesScalar, "scalar"};
+}
+
+static const Kernel &ActiveKernel() noexcept
+{
+    static const Kernel kernel = SelectKernel();
+    return kernel;
+}
+
+size_t CountMismatches(const char *a, const char *b, const size_t n, const size_t limit) noexcept
+{
+    return ActiveKernel().fun(a, b, n, limit);
+}
+
+const char *MismatchKernel() noexcept
+{
+    return ActiveKernel().name;
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
@@ -0,0 +1,147 @@
+#ifndef LIB_HAMMING_H
+#define LIB_HAMMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "global.h"
+#include "kmer.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    Count the positions where the \a n bytes at \a a and \a b differ.
+
+    The bytes are compared 32 or 16 at a time with AVX2 or SSE4.2, picked
+    at run time from what the CPU supports, or one by one otherwise. Once
+    more than \a limit differences are found the count stops early and
+    some value greater than \a limit is returned.
+ */
+size_t CountMismatches(const char *a, const char *b, const size_t n,
+    const size_t limit = std::numeric_limits<size_t>::max()) noexcept;
+
+/*!
+    Name of the kernel used by CountMismatches(): "avx2", "sse4.2" or
+    "scalar".
+ */
+const char *MismatchKernel() noexcept;
+
+inline int Popcount(hash_t x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    for (; x; x &= x - 1) count++;
+    return count;
+#endif
+}
+
+/*!
+    Number of bases which differ between two 2-bit packed k-mers: a base
+    differs when either bit of its XOR is set.
+ */
+inline int PackedMismatches(const hash_t x, const hash_t y) noexcept
+{
+    hash_t diff = x ^ y;
+    return Popcount((diff | (diff >> 1)) & 0x5555555555555555ULL);
+}
+
+/*!
+    Substitute bases at positions \a from and beyond of \a code, up to \a d
+    of them, handing every variant to \a fn. XOR of a base with 1, 2 or 3
+    gives the three other bases, so each variant comes out exactly once.
+ */
+template <typename Fn>
+inline void ForEachSubstitution(const hash_t code, const int from, const int k, const int d, Fn &fn)
+{
+    for (int position = from; position < k; position++) {
+        for (hash_t mask = 1; mask <= 3; mask++) {
+            hash_t neighbor = code ^ (mask << 2*position);
+            fn(neighbor);
+            if (d > 1)
+                ForEachSubstitution(neighbor, position + 1, k, d - 1, fn);
+        }
+    }
+}
+
+/*!
+    Call \a fn(neighbor) on the code of every k-mer within Hamming distance
+    \a d of the 2-bit packed k-mer \a code, itself included, each exactly
+    once and in no particular order.
+
+    The neighborhood is enumerated as sets of mismatch positions times the
+    substitutions at each, by XOR masks on the code, so nothing is
+    allocated per neighbor. \a k must be at most 32.
+ */
+template <typename Fn>
+inline void ForEachNeighbor(const hash_t code, const int k, const int d, Fn fn)
+{
+    fn(code);
+    if (d > 0)
+        ForEachSubstitution(code, 0, k, d < k ? d : k, fn);
+}
+
+/*!
+    Substitute bases like ForEachSubstitution(), carrying along \a reverse,
+    the code of the reverse complement: a base at position i of \a code is
+    at position k - 1 - i of \a reverse, and complementing commutes with
+    the XOR, so both codes change by one mask each.
+ */
+template <typename Fn>
+inline void ForEachSubstitutionPair(const hash_t code, const hash_t reverse,
+    const int from, const int k, const int d, Fn &fn)
+{
+    for (int position = from; position < k; position++) {
+        for (hash_t mask = 1; mask <= 3; mask++) {
+            hash_t neighbor = code ^ (mask << 2*position);
+            hash_t neighbor_reverse = reverse ^ (mask << 2*(k - 1 - position));
+            fn(neighbor, neighbor_reverse);
+            if (d > 1)
+                ForEachSubstitutionPair(neighbor, neighbor_reverse, position + 1, k, d - 1, fn);
+        }
+    }
+}
+
+/*!
+    Call \a fn(neighbor, reverse) on the d-neighborhood of \a code like
+    ForEachNeighbor(), along with the code of the reverse complement of
+    each neighbor, kept up to date without reversing any code.
+ */
+template <typename Fn>
+inline void ForEachNeighborPair(const hash_t code, const int k, const int d, Fn fn)
+{
+    hash_t reverse = ReverseComplementCode(code, k);
+    fn(code, reverse);
+    if (d > 0)
+        ForEachSubstitutionPair(code, reverse, 0, k, d < k ? d : k, fn);
+}
+
+/*!
+    Size of the d-neighborhood of a k-mer: the sum over j <= \a d of
+    C(k, j) * 3^j.
+ */
+inline size_t NeighborCount(const int k, const int d) noexcept
+{
+    size_t count = 0, term = 1;
+    for (int j = 0; j <= d && j <= k; j++) {
+        count += term;
+        term = term * 3 * (k - j) / (j + 1);
+    }
+    return count;
+}
+
+/*!
+    Append the codes of the d-neighborhood of \a code to \a out, which can
+    be reused from one k-mer to the next without allocating.
+ */
+inline void Neighbors(const hash_t code, const int k, const int d, std::vector<hash_t> &out)
+{
+    ForEachNeighbor(code, k, d, [&out](const hash_t neighbor) { out.push_back(neighbor); });
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_HAMMING_H
@@ -0,0 +1,38 @@
+#include "kmer.h"
+
+#include "utils.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+const char INT_TO_BASE[4] = {'A', 'C', 'G', 'T'};
+
+const int BASE_TO_INT[256] = {
+    REPEAT_LIST_N(-1, 60), REPEAT_LIST_N(-1, 5),
+//  A,  B, C,  D,  E,  F, G,  H,  I,  J,  K,  L,  M,  N,  O,  P,  Q,  R,  S, T,  U,  V,  W,  X,  Y,  Z
+    0, -1, 1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1,
+    REPEAT_LIST_N(-1, 6),
+//  a,  b, c,  d,  e,  f, g,  h,  i,  j,  k,  l,  m,  n,  o,  p,  q,  r,  s, t,  u,  v,  w,  x,  y,  z
+    0, -1, 1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1,
+    REPEAT_LIST_N(-1, 100), REPEAT_LIST_N(-1, 30), REPEAT_LIST_N(-1, 3)
+};
+
+std::string SpellKmer(const hash_t code, const int k)
+{
+    std::string kmer(k, 'A');
+    hash_t rest = code;
+    for (int i = k - 1; i >= 0; i--, rest >>= 2)
+        kmer[i] = INT_TO_BASE[rest & 3];
+    return kmer;
+}
+
+/*!
+    \a k must be in [1, 64].
+ */
+std::string SpellKmer(const hash128_t &code, const int k)
+{
+    if (k <= 32)
+        return SpellKmer(code.low, k);
+    return SpellKmer(code.high, k - 32) + SpellKmer(code.low, 32);
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
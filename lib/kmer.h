@@ -0,0 +1,289 @@
+#ifndef LIB_KMER_H
+#define LIB_KMER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "global.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+typedef unsigned long long hash_t;
+
+/*!
+    2-bit packed code of a k-mer of up to 64 bases, \c high holding the
+    first k - 32 bases and \c low the last 32.
+ */
+struct hash128_t {
+    hash_t high = 0;
+    hash_t low = 0;
+
+    bool operator==(const hash128_t &other) const noexcept
+    {
+        return high == other.high && low == other.low;
+    }
+    bool operator!=(const hash128_t &other) const noexcept { return !(*this == other); }
+    bool operator<(const hash128_t &other) const noexcept
+    {
+        return high < other.high || (high == other.high && low < other.low);
+    }
+};
+
+/*!
+    2-bit code of each byte: A/a = 0, C/c = 1, G/g = 2, T/t = 3 and -1 for
+    everything else. The code of the complementary base is \c 3 - code.
+ */
+extern const int BASE_TO_INT[256];
+extern const char INT_TO_BASE[4];
+
+/*!
+    Spell out the k-mer of 2-bit code \a code in upper case, whatever the
+    case of the text it was encoded from.
+ */
+std::string SpellKmer(const hash_t code, const int k);
+std::string SpellKmer(const hash128_t &code, const int k);
+
+/*!
+    2-bit code of the reverse complement of the k-mer of code \a code,
+    computed on the whole word: complement every base, reverse the order
+    of the 32 bases, and drop the 32 - \a k unused ones. \a k must be in
+    [1, 32].
+ */
+inline hash_t ReverseComplementCode(hash_t code, const int k) noexcept
+{
+    code = ~code;
+    code = ((code >> 2) & 0x3333333333333333ULL) | ((code & 0x3333333333333333ULL) << 2);
+    code = ((code >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((code & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    code = ((code >> 8) & 0x00FF00FF00FF00FFULL) | ((code & 0x00FF00FF00FF00FFULL) << 8);
+    code = ((code >> 16) & 0x0000FFFF0000FFFFULL) | ((code & 0x0000FFFF0000FFFFULL) << 16);
+    code = (code >> 32) | (code << 32);
+    return code >> (64 - 2*k);
+}
+
+/*!
+    Canonical code of a k-mer: the smaller of its code and the code of its
+    reverse complement, so both strands of a k-mer share one code.
+
+    Counts under canonical codes are counts on both strands of the text:
+    the canonical count of a k-mer is its count plus the count of its
+    reverse complement. So an occurrence of a palindrome, a k-mer equal to
+    its own reverse complement, counts twice, as it is read on both
+    strands at once. This holds for every canonical count of the library,
+    with or without mismatches.
+ */
+inline hash_t CanonicalCode(const hash_t code, const int k) noexcept
+{
+    hash_t reverse = ReverseComplementCode(code, k);
+    return code < reverse ? code : reverse;
+}
+
+/*!
+    \brief Rolling 2-bit code of a k-mer and of its reverse complement.
+
+    Bases are shifted in one at a time, so the codes of consecutive k-mers
+    cost O(1) each whatever \a k is. forward() equals PatternToNumber() of
+    the last \a k bases and reverse() equals PatternToNumber() of their
+    reverse complement. \a k must be in [1, 32].
+ */
+class RollingKmer {
+
+public:
+    static constexpr int MAX_K = 32;
+
+    explicit RollingKmer(const int k) noexcept
+        : m_k(k),
+          m_mask(k >= 32 ? ~hash_t(0) : (hash_t(1) << 2*k) - 1),
+          m_shift(2*(k - 1))
+    {
+
+    }
+
+    void push(const int code) noexcept
+    {
+        m_forward = ((m_forward << 2) | code) & m_mask;
+        m_reverse = (m_reverse >> 2) | (hash_t(3 - code) << m_shift);
+        if (m_length < m_k) ++m_length;
+    }
+
+    /*!
+        Shift \a base in. A non-ACGT base restarts the k-mer and false is
+        returned.
+     */
+    bool push(const char base) noexcept
+    {
+        int code = BASE_TO_INT[static_cast<unsigned char>(base)];
+        if (code < 0) {
+            reset();
+            return false;
+        }
+
+        push(code);
+        return true;
+    }
+
+    void reset() noexcept
+    {
+        m_forward = m_reverse = 0;
+        m_length = 0;
+    }
+
+    bool ready() const noexcept { return m_length == m_k; }
+    int k() const noexcept { return m_k; }
+    hash_t forward() const noexcept { return m_forward; }
+    hash_t reverse() const noexcept { return m_reverse; }
+    hash_t canonical() const noexcept { return m_forward < m_reverse ? m_forward : m_reverse; }
+
+    /*!
+        What the k-mer adds to the count of its canonical code: 2 for a
+        palindrome and 1 otherwise, see CanonicalCode().
+     */
+    int canonicalWeight() const noexcept { return m_forward == m_reverse ? 2 : 1; }
+
+private:
+    int m_k;
+    hash_t m_mask;
+    int m_shift;
+    int m_length = 0;
+    hash_t m_forward = 0;
+    hash_t m_reverse = 0;
+};
+
+/*!
+    \brief Rolling 2-bit code of a k-mer of up to 64 bases.
+
+    The wide counterpart of RollingKmer for k-mers which do not fit a
+    hash_t. Only the forward code is kept. \a k must be in [1, 64].
+ */
+class RollingKmer128 {
+
+public:
+    static constexpr int MAX_K = 64;
+
+    explicit RollingKmer128(const int k) noexcept
+        : m_k(k),
+          m_high_mask(k <= 32 ? 0 : k >= 64 ? ~hash_t(0) : (hash_t(1) << 2*(k - 32)) - 1),
+          m_low_mask(k >= 32 ? ~hash_t(0) : (hash_t(1) << 2*k) - 1)
+    {
+
+    }
+
+    void push(const int code) noexcept
+    {
+        m_code.high = ((m_code.high << 2) | (m_code.low >> 62)) & m_high_mask;
+        m_code.low = ((m_code.low << 2) | code) & m_low_mask;
+        if (m_length < m_k) ++m_length;
+    }
+
+    bool push(const char base) noexcept
+    {
+        int code = BASE_TO_INT[static_cast<unsigned char>(base)];
+        if (code < 0) {
+            reset();
+            return false;
+        }
+
+        push(code);
+        return true;
+    }
+
+    void reset() noexcept
+    {
+        m_code = hash128_t();
+        m_length = 0;
+    }
+
+    bool ready() const noexcept { return m_length == m_k; }
+    int k() const noexcept { return m_k; }
+    hash128_t forward() const noexcept { return m_code; }
+
+private:
+    int m_k;
+    hash_t m_high_mask;
+    hash_t m_low_mask;
+    int m_length = 0;
+    hash128_t m_code;
+};
+
+/*!
+    \brief Rolling polynomial hash of a k-mer of any length.
+
+    The hash reads the 2-bit codes of the last \a k bases, plus one, as the
+    digits of a number in base HASH_BASE modulo 2^64, which the wrap-around
+    of hash_t arithmetic computes for free. Distinct k-mers may share a
+    hash, so a match of hashes must be verified. The last \a k codes are
+    kept to take the outgoing base off the hash.
+ */
+class RollingKmerHash {
+
+public:
+    // An odd multiplier with well mixed bits (2^64 / golden ratio).
+    static constexpr hash_t HASH_BASE = 0x9e3779b97f4a7c15ULL;
+
+    explicit RollingKmerHash(const int k)
+        : m_k(k), m_window(k > 0 ? k : 1, 0)
+    {
+        for (int i = 1; i < k; i++)
+            m_power *= HASH_BASE;
+    }
+
+    bool push(const char base) noexcept
+    {
+        int code = BASE_TO_INT[static_cast<unsigned char>(base)];
+        if (code < 0) {
+            reset();
+            return false;
+        }
+
+        uint8_t &slot = m_window[m_head];
+        if (m_length == m_k)
+            m_hash -= slot * m_power;
+        else
+            ++m_length;
+
+        slot = code + 1;
+        m_hash = m_hash * HASH_BASE + slot;
+        if (++m_head == m_window.size()) m_head = 0;
+        return true;
+    }
+
+    void reset() noexcept
+    {
+        m_hash = 0;
+        m_length = 0;
+        m_head = 0;
+    }
+
+    bool ready() const noexcept { return m_length == m_k; }
+    int k() const noexcept { return m_k; }
+    hash_t forward() const noexcept { return m_hash; }
+
+private:
+    int m_k;
+    hash_t m_power = 1;
+    hash_t m_hash = 0;
+    int m_length = 0;
+    size_t m_head = 0;
+    std::vector<uint8_t> m_window;
+};
+
+/*!
+    Call \a fn(i, kmer) for every k-mer of \a text, where \a i is its
+    starting position and \a kmer the RollingKmer holding its codes. Each
+    base is shifted in once, so the whole text is encoded in O(n) whatever
+    \a k is. k-mers containing a non-ACGT byte are skipped.
+ */
+template <typename Fn>
+inline void ForEachKmer(const std::string_view text, const int k, Fn fn)
+{
+    RollingKmer rolling(k);
+    for (size_t i = 0; i < text.length(); i++) {
+        if (rolling.push(text[i]) && rolling.ready())
+            fn(i + 1 - k, static_cast<const RollingKmer &>(rolling));
+    }
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_KMER_H
@@ -0,0 +1,503 @@
+#include "kmerdb.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BIOUTILS_HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+static const char DATABASE_FILE_MAGIC[8] = {'B', 'I', 'O', 'K', 'M', 'D', 'B', '1'};
+
+static const uint32_t CANONICAL_FLAG = 1;
+static const uint32_t DENSE_FLAG = 2;
+
+struct DatabaseHeader {
+    char magic[8];
+    uint32_t k;
+    uint32_t flags;
+    uint64_t size;
+    uint64_t total;
+    uint32_t index_bits;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(DatabaseHeader) == 40, "The keys must start 8-byte aligned.");
+
+// Values written at a time when a column is streamed out.
+static const size_t WRITE_CHUNK_SIZE = 1 << 14;
+
+/*!
+    A database file being written. Everything goes to a temporary file
+    which only replaces \a file_name once commit() succeeds, so a failed
+    write never leaves a truncated database behind, and an input of
+    MergeKmerDatabases() which is still mapped can be the output.
+ */
+class DatabaseOutput {
+
+public:
+    explicit DatabaseOutput(const std::string &file_name)
+        : m_file_name(file_name), m_temp_name(file_name + ".tmp"),
+          m_out(m_temp_name, std::ios::binary)
+    {
+        if (!m_out)
+            throw std::runtime_error("Can not open file: " + m_temp_name);
+    }
+
+    ~DatabaseOutput()
+    {
+        if (!m_committed) {
+            m_out.close();
+            std::remove(m_temp_name.c_str());
+        }
+    }
+
+    void write(const void *data, const size_t length)
+    {
+        m_out.write(static_cast<const char *>(data), length);
+    }
+
+    void writeHeader(const int k, const uint32_t flags, const uint64_t size, const uint64_t total,
+                     const int index_bits = 0)
+    {
+        DatabaseHeader header;
+        std::memcpy(header.magic, DATABASE_FILE_MAGIC, sizeof(header.magic));
+        header.k = k;
+        header.flags = flags;
+        header.size = size;
+        header.total = total;
+        header.index_bits = index_bits;
+        header.reserved = 0;
+
+        m_out.seekp(0);
+        write(&header, sizeof(header));
+    }
+
+    void commit()
+    {
+        m_out.close();
+        if (!m_out || std::rename(m_temp_name.c_str(), m_file_name.c_str()) != 0)
+            throw std::runtime_error("Can not write file: " + m_file_name);
+        m_committed = true;
+    }
+
+private:
+    std::string m_file_name;
+    std::string m_temp_name;
+    std::ofstream m_out;
+    bool m_committed = false;
+};
+
+/*!
+    Bucket of \a code in the index of a sparse database: its \a bits high
+    bits out of 2 * \a k.
+ */
+static inline size_t BucketOf(const uint64_t code, const int k, const int bits) noexcept
+{
+    return bits == 0 ? 0 : code >> (2*k - bits);
+}
+
+/*!
+    Offset of the bucket index in a sparse database of \a size k-mers,
+    after the codes and the counts, rounded up to 8 bytes.
+ */
+static inline uint64_t IndexOffset(const uint64_t size) noexcept
+{
+    uint64_t end = sizeof(DatabaseHeader) + size * (sizeof(uint64_t) + sizeof(uint32_t));
+    return (end + 7) & ~uint64_t(7);
+}
+
+/*!
+    Index of the sorted codes of a sparse database, written after them and
+    their counts: for each value of the index_bits high bits of a code, the
+    position of the first code having them, and then the number of codes.
+    There are 16 to 32 codes per bucket, so a lookup reads one start and
+    searches a couple of cache lines instead of the whole array of codes,
+    for half a byte per k-mer.
+ */
+class BucketIndex {
+
+public:
+    BucketIndex(const int k, const uint64_t size) : m_k(k)
+    {
+        while (m_bits < 2*k && (uint64_t(32) << m_bits) <= size)
+            m_bits++;
+        m_starts.assign((size_t(1) << m_bits) + 1, 0);
+    }
+
+    int bits() const noexcept { return m_bits; }
+
+    /*!
+        Add the next code, in increasing order.
+     */
+    void add(const uint64_t code) noexcept { m_starts[BucketOf(code, m_k, m_bits) + 1]++; }
+
+    void write(DatabaseOutput &out, const uint64_t size)
+    {
+        if (size % 2 != 0) {
+            uint32_t padding = 0;
+            out.write(&padding, sizeof(padding));
+        }
+        std::partial_sum(m_starts.begin(), m_starts.end(), m_starts.begin());
+        out.write(m_starts.data(), m_starts.size() * sizeof(uint64_t));
+    }
+
+private:
+    int m_k;
+    int m_bits = 0;
+    std::vector<uint64_t> m_starts;
+};
+
+/*!
+    Write \a fn(i) for i in [0, n) as values of type \a T.
+ */
+template <typename T, typename Fn>
+static void WriteColumn(DatabaseOutput &out, const size_t n, Fn fn)
+{
+    std::vector<T> chunk;
+    chunk.reserve(std::min(n, WRITE_CHUNK_SIZE));
+    for (size_t i = 0; i < n; i++) {
+        chunk.push_back(fn(i));
+        if (chunk.size() == WRITE_CHUNK_SIZE || i + 1 == n) {
+            out.write(chunk.data(), chunk.size() * sizeof(T));
+            chunk.clear();
+        }
+    }
+}
+
+/*!
+    \brief Write the counts of \a counter to the database \a file_name.
+
+    \a canonical records whether \a counter holds canonical codes, as
+    counted by CountKmers(), so that KmerDatabase::count() canonicalizes
+    the k-mers it is asked for. The dense layout is written when its 4^k
+    counts take no more room than the codes and counts of the distinct
+    k-mers.
+ */
+void WriteKmerDatabase(const std::string &file_name, const KmerCounter &counter, const bool canonical)
+{
+    const int k = counter.k();
+    std::vector<std::pair<hash_t, uint>> entries;
+    uint64_t total = 0;
+    counter.forEach([&](const hash_t code, const uint count) {
+        entries.emplace_back(code, count);
+        total += count;
+    });
+
+    bool dense = k <= KmerCounter::DENSE_MAX_K
+        && (uint64_t(sizeof(uint32_t)) << 2*k) <= entries.size() * (sizeof(uint64_t) + sizeof(uint32_t));
+    uint32_t flags = (canonical ? CANONICAL_FLAG : 0) | (dense ? DENSE_FLAG : 0);
+
+    DatabaseOutput out(file_name);
+    if (dense) {
+        out.writeHeader(k, flags, entries.size(), total);
+        std::vector<uint32_t> counts(size_t(1) << 2*k, 0);
+        for (const auto &entry : entries)
+            counts[entry.first] = entry.second;
+        out.write(counts.data(), counts.size() * sizeof(uint32_t));
+    } else {
+        std::sort(entries.begin(), entries.end());
+        BucketIndex index(k, entries.size());
+        for (const auto &entry : entries)
+            index.add(entry.first);
+
+        out.writeHeader(k, flags, entries.size(), total, index.bits());
+        WriteColumn<uint64_t>(out, entries.size(), [&](const size_t i) { return entries[i].first; });
+        WriteColumn<uint32_t>(out, entries.size(), [&](const size_t i) { return entries[i].second; });
+        index.write(out, entries.size());
+    }
+    out.commit();
+}
+
+/*!
+    \brief Merge the k-mer databases \a inputs into \a file_name, adding up
+    the counts of a k-mer found in several of them.
+
+    All inputs must have the same \c k and canonical mode. Databases of up
+    to KmerCounter::DENSE_MAX_K are summed in a KmerCounter. Larger ones are
+    all sparse, and are merged by walking their sorted codes together, so
+    nothing but the output is ever held in memory. A count which would
+    overflow is capped at the largest 32-bit value.
+ */
+void MergeKmerDatabases(const std::string &file_name, const std::vector<std::string> &inputs)
+{
+    if (inputs.empty())
+        throw std::runtime_error("No k-mer database to merge.");
+
+    std::vector<KmerDatabase> databases;
+    for (const auto &input : inputs) {
+        databases.emplace_back(input);
+        if (databases.back().k() != databases[0].k() || databases.back().isCanonical() != databases[0].isCanonical())
+            throw std::runtime_error("Can not merge k-mer databases of different k or canonical mode: " + input);
+    }
+
+    const int k = databases[0].k();
+    const bool canonical = databases[0].isCanonical();
+
+    if (k <= KmerCounter::DENSE_MAX_K) {
+        KmerCounter counter(k);
+        for (const auto &db : databases) {
+            db.forEach([&counter](const hash_t code, const uint count) {
+                uint sum = counter.count(code);
+                counter.add(code, std::min<uint>(count, std::numeric_limits<uint32_t>::max() - sum));
+            });
+        }
+        WriteKmerDatabase(file_name, counter, canonical);
+        return;
+    }
+
+    // Call fn(code, count) on the merged k-mers in order of code.
+    auto merge = [&databases](const std::function<void(uint64_t, uint32_t)> &fn) {
+        typedef std::pair<uint64_t, size_t> Head;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        std::vector<size_t> next(databases.size(), 0);
+        for (size_t i = 0; i < databases.size(); i++) {
+            if (!databases[i].empty())
+                heads.emplace(databases[i].m_keys[0], i);
+        }
+
+        while (!heads.empty()) {
+            uint64_t code = heads.top().first;
+            uint64_t count = 0;
+            while (!heads.empty() && heads.top().first == code) {
+                const KmerDatabase &db = databases[heads.top().second];
+                size_t &i = next[heads.top().second];
+                heads.pop();
+                count += db.m_counts[i];
+                if (++i < db.m_size)
+                    heads.emplace(db.m_keys[i], &db - databases.data());
+            }
+            fn(code, static_cast<uint32_t>(std::min<uint64_t>(count, std::numeric_limits<uint32_t>::max())));
+        }
+    };
+
+    // The counts follow all the codes, so the codes are written in a first
+    // merge, which also finds the header, and the counts and the index in
+    // a second one.
+    DatabaseOutput out(file_name);
+    uint64_t size = 0, total = 0;
+    out.writeHeader(k, canonical ? CANONICAL_FLAG : 0, 0, 0);
+
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> counts;
+    keys.reserve(WRITE_CHUNK_SIZE);
+    counts.reserve(WRITE_CHUNK_SIZE);
+    merge([&](const uint64_t code, const uint32_t count) {
+        keys.push_back(code);
+        size++;
+        total += count;
+        if (keys.size() == WRITE_CHUNK_SIZE) {
+            out.write(keys.data(), keys.size() * sizeof(uint64_t));
+            keys.clear();
+        }
+    });
+    out.write(keys.data(), keys.size() * sizeof(uint64_t));
+    BucketIndex index(k, size);
+    merge([&](const uint64_t code, const uint32_t count) {
+        index.add(code);
+        counts.push_back(count);
+        if (counts.size() == WRITE_CHUNK_SIZE) {
+            out.write(counts.data(), counts.size() * sizeof(uint32_t));
+            counts.clear();
+        }
+    });
+    out.write(counts.data(), counts.size() * sizeof(uint32_t));
+    index.write(out, size);
+
+    out.writeHeader(k, canonical ? CANONICAL_FLAG : 0, size, total, index.bits());
+    out.commit();
+}
+
+/*!
+    Open the database \a file_name.
+
+    Throws std::runtime_error if the file can not be read or is not a
+    complete k-mer database.
+ */
+KmerDatabase::KmerDatabase(const std::string &file_name)
+{
+    const char *data = nullptr;
+    size_t length = 0;
+
+#ifdef BIOUTILS_HAVE_MMAP
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error("Can not open file: " + file_name);
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= static_cast<off_t>(sizeof(DatabaseHeader))) {
+        length = static_cast<size_t>(st.st_size);
+        void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED) {
+            m_mapped = addr;
+            m_mapped_length = length;
+            data = static_cast<const char *>(addr);
+        }
+    }
+    close(fd);
+#else
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::runtime_error("Can not open file: " + file_name);
+
+    length = static_cast<size_t>(file.tellg());
+    m_buffer.resize((length + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    file.seekg(0);
+    if (file.read(reinterpret_cast<char *>(m_buffer.data()), length))
+        data = reinterpret_cast<const char *>(m_buffer.data());
+#endif
+
+    DatabaseHeader header;
+    bool valid = data && length >= sizeof(header);
+    if (valid)
+        std::memcpy(&header, data, sizeof(header));
+
+    valid = valid && std::equal(header.magic, header.magic + sizeof(header.magic), DATABASE_FILE_MAGIC)
+        && header.k >= 1 && header.k <= RollingKmer::MAX_K;
+    if (valid && (header.flags & DENSE_FLAG)) {
+        valid = header.k <= KmerCounter::DENSE_MAX_K
+            && length == sizeof(header) + (sizeof(uint32_t) << 2*header.k);
+    } else if (valid) {
+        size_t entry = sizeof(uint64_t) + sizeof(uint32_t);
+        valid = header.size <= (length - sizeof(header)) / entry
+            && header.index_bits <= 2 * header.k && header.index_bits < 40
+            && length == IndexOffset(header.size) + ((uint64_t(1) << header.index_bits) + 1) * sizeof(uint64_t);
+    }
+
+    if (!valid) {
+        release();
+        throw std::runtime_error("Not a k-mer database: " + file_name);
+    }
+
+    m_k = header.k;
+    m_canonical = header.flags & CANONICAL_FLAG;
+    m_size = header.size;
+    m_total = header.total;
+    if (header.flags & DENSE_FLAG) {
+        m_counts = reinterpret_cast<const uint32_t *>(data + sizeof(header));
+    } else {
+        m_keys = reinterpret_cast<const uint64_t *>(data + sizeof(header));
+        m_counts = reinterpret_cast<const uint32_t *>(m_keys + m_size);
+        m_buckets = reinterpret_cast<const uint64_t *>(data + IndexOffset(m_size));
+        m_index_bits = header.index_bits;
+        if (m_buckets[0] != 0 || m_buckets[size_t(1) << m_index_bits] != m_size) {
+            release();
+            throw std::runtime_error("Not a k-mer database: " + file_name);
+        }
+    }
+}
+
+KmerDatabase::~KmerDatabase()
+{
+    release();
+}
+
+KmerDatabase::KmerDatabase(KmerDatabase &&other) noexcept
+    : m_k(std::exchange(other.m_k, 0)),
+      m_canonical(std::exchange(other.m_canonical, false)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_total(std::exchange(other.m_total, 0)),
+      m_keys(std::exchange(other.m_keys, nullptr)),
+      m_counts(std::exchange(other.m_counts, nullptr)),
+      m_buckets(std::exchange(other.m_buckets, nullptr)),
+      m_index_bits(std::exchange(other.m_index_bits, 0)),
+      m_mapped(std::exchange(other.m_mapped, nullptr)),
+      m_mapped_length(std::exchange(other.m_mapped_length, 0)),
+      m_buffer(std::move(other.m_buffer))
+{
+
+}
+
+KmerDatabase &KmerDatabase::operator=(KmerDatabase &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_k = std::exchange(other.m_k, 0);
+        m_canonical = std::exchange(other.m_canonical, false);
+        m_size = std::exchange(other.m_size, 0);
+        m_total = std::exchange(other.m_total, 0);
+        m_keys = std::exchange(other.m_keys, nullptr);
+        m_counts = std::exchange(other.m_counts, nullptr);
+        m_buckets = std::exchange(other.m_buckets, nullptr);
+        m_index_bits = std::exchange(other.m_index_bits, 0);
+        m_mapped = std::exchange(other.m_mapped, nullptr);
+        m_mapped_length = std::exchange(other.m_mapped_length, 0);
+        m_buffer = std::move(other.m_buffer);
+    }
+
+    return *this;
+}
+
+void KmerDatabase::release() noexcept
+{
+#ifdef BIOUTILS_HAVE_MMAP
+    if (m_mapped)
+        munmap(m_mapped, m_mapped_length);
+#endif
+    m_mapped = nullptr;
+    m_mapped_length = 0;
+}
+
+/*!
+    Return the count of the k-mer of code \a code. In a canonical database
+    \a code must be canonical.
+ */
+uint KmerDatabase::count(const hash_t code) const noexcept
+{
+    if (isDense())
+        return code < (hash_t(1) << 2*m_k) ? m_counts[code] : 0;
+
+    if (m_k < 32 && code >> 2*m_k)
+        return 0;
+
+    size_t bucket = BucketOf(code, m_k, m_index_bits);
+    const uint64_t *last = m_keys + m_buckets[bucket + 1];
+    const uint64_t *it = std::lower_bound(m_keys + m_buckets[bucket], last, code);
+    return it != last && *it == code ? m_counts[it - m_keys] : 0;
+}
+
+/*!
+    Return the count of \a kmer, regardless of its case, or 0 if it is not
+    a k-mer of ACGT bases. In a canonical database, \a kmer and its reverse
+    complement have the same count.
+ */
+uint KmerDatabase::count(const std::string_view kmer) const noexcept
+{
+    if (kmer.length() != static_cast<size_t>(m_k))
+        return 0;
+
+    RollingKmer rolling(m_k);
+    for (char base : kmer) {
+        if (!rolling.push(base))
+            return 0;
+    }
+
+    return count(m_canonical ? rolling.canonical() : rolling.forward());
+}
+
+/*!
+    Return the \a n most frequent k-mers as (code, count) pairs, by
+    decreasing count, and by increasing code among equal counts. Only \a n
+    pairs are held while the database is scanned.
+ */
+std::vector<std::pair<hash_t, uint>> KmerDatabase::top(const size_t n) const
+{
+    TopCounts<hash_t> top(n);
+    forEach([&top](const hash_t code, const uint count) { top.add(code, count); });
+    return top.take();
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
@@ -0,0 +1,113 @@
+#ifndef LIB_KMERDB_H
+#define LIB_KMERDB_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "global.h"
+#include "counter.h"
+#include "kmer.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    \brief Read-only k-mer count database written by WriteKmerDatabase().
+
+    A database file starts with a header recording \c k, whether k-mers
+    were counted canonically, the number of distinct k-mers and the total
+    count. It is followed either by a dense array of 4^k 32-bit counts
+    indexed by the k-mer code, or by the sorted 64-bit codes of the
+    distinct k-mers, their counts in the same order, and an index of the
+    codes by their high bits. The smaller of the two layouts is written,
+    so only small \c k are dense.
+
+    The file is memory-mapped, so opening a database costs nothing whatever
+    its size and only the pages touched by lookups are read. A lookup is
+    O(1) in a dense database, and in a sparse one a binary search within
+    the 16 to 32 codes sharing its high bits. Numbers are stored in the
+    byte order of the host.
+
+    \code
+    KmerDatabase db(file_name);
+    for (const auto &[code, count] : db.top(10))
+        std::cout << NumberToPatternBitwise(code, db.k()) << '\t' << count << '\n';
+    \endcode
+ */
+class KmerDatabase {
+
+public:
+    explicit KmerDatabase(const std::string &file_name) noexcept(false);
+    ~KmerDatabase();
+
+    KmerDatabase(const KmerDatabase &) = delete;
+    KmerDatabase &operator=(const KmerDatabase &) = delete;
+    KmerDatabase(KmerDatabase &&other) noexcept;
+    KmerDatabase &operator=(KmerDatabase &&other) noexcept;
+
+    int k() const noexcept { return m_k; }
+    bool isCanonical() const noexcept { return m_canonical; }
+    bool isDense() const noexcept { return m_keys == nullptr; }
+
+    /*!
+        Number of distinct k-mers.
+     */
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+
+    /*!
+        Sum of the counts of all k-mers.
+     */
+    uint64_t total() const noexcept { return m_total; }
+
+    uint count(const hash_t code) const noexcept;
+    uint count(const std::string_view kmer) const noexcept;
+
+    /*!
+        Call \a fn(code, count) on every k-mer with a non-zero count, in
+        increasing order of code.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        if (isDense()) {
+            size_t cells = size_t(1) << 2*m_k;
+            for (size_t i = 0; i < cells; i++) {
+                if (m_counts[i] != 0)
+                    fn(hash_t(i), uint(m_counts[i]));
+            }
+        } else {
+            for (size_t i = 0; i < m_size; i++)
+                fn(hash_t(m_keys[i]), uint(m_counts[i]));
+        }
+    }
+
+    std::vector<std::pair<hash_t, uint>> top(const size_t n) const;
+
+private:
+    friend void MergeKmerDatabases(const std::string &file_name, const std::vector<std::string> &inputs);
+
+    void release() noexcept;
+
+    int m_k = 0;
+    bool m_canonical = false;
+    size_t m_size = 0;
+    uint64_t m_total = 0;
+    const uint64_t *m_keys = nullptr;
+    const uint32_t *m_counts = nullptr;
+    const uint64_t *m_buckets = nullptr;
+    int m_index_bits = 0;
+
+    void *m_mapped = nullptr;
+    size_t m_mapped_length = 0;
+    std::vector<uint64_t> m_buffer;
+};
+
+void WriteKmerDatabase(const std::string &file_name, const KmerCounter &counter, const bool canonical);
+void MergeKmerDatabases(const std::string &file_name, const std::vector<std::string> &inputs);
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_KMERDB_H
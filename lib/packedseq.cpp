@@ -0,0 +1,104 @@
+#include "packedseq.h"
+
+#include <algorithm>
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+PackedSequence::PackedSequence(const std::string_view seq)
+{
+    append(seq);
+}
+
+void PackedSequence::reserve(const size_t n)
+{
+    m_words.reserve((n + 31) / 32);
+    m_ambiguous_mask.reserve((n + 63) / 64);
+}
+
+void PackedSequence::clear() noexcept
+{
+    m_words.clear();
+    m_ambiguous_mask.clear();
+    m_size = 0;
+    m_ambiguous = 0;
+}
+
+/*!
+    Pack \a seq after the current end of the sequence. This allows building
+    a whole genome from the records or chunks of a streaming reader.
+ */
+void PackedSequence::append(const std::string_view seq)
+{
+    size_t new_size = m_size + seq.length();
+    m_words.resize((new_size + 31) / 32, 0);
+    m_ambiguous_mask.resize((new_size + 63) / 64, 0);
+
+    size_t i = m_size;
+    for (const char c : seq) {
+        int code = BASE_TO_INT[static_cast<unsigned char>(c)];
+        if (code < 0) {
+            m_ambiguous_mask[i >> 6] |= uint64_t(1) << (i & 63);
+            m_ambiguous++;
+            code = 0;
+        }
+        m_words[i >> 5] |= uint64_t(code) << (62 - 2*(i & 31));
+        i++;
+    }
+
+    m_size = new_size;
+}
+
+/*!
+    Check whether any base in [pos, pos + len) is ambiguous. \a len must not
+    be more than 64.
+ */
+bool PackedSequence::anyAmbiguous(const size_t pos, const size_t len) const noexcept
+{
+    if (m_ambiguous == 0)
+        return false;
+
+    size_t word = pos >> 6;
+    size_t offset = pos & 63;
+    uint64_t bits = m_ambiguous_mask[word] >> offset;
+    if (offset + len > 64 && word + 1 < m_ambiguous_mask.size())
+        bits |= m_ambiguous_mask[word + 1] << (64 - offset);
+    if (len < 64)
+        bits &= (uint64_t(1) << len) - 1;
+
+    return bits != 0;
+}
+
+/*!
+    Extract the code of the \a k -mer starting at \a pos into \a code in
+    O(1). Return false if the k-mer runs past the end of the sequence or
+    contains an ambiguous base. \a k must be in [1, 32].
+ */
+bool PackedSequence::kmer(const size_t pos, const int k, hash_t &code) const noexcept
+{
+    if (k <= 0 || pos + k > m_size || anyAmbiguous(pos, k))
+        return false;
+
+    size_t word = pos >> 5;
+    int offset = 2*(pos & 31);
+    uint64_t bits = m_words[word] << offset;
+    if (offset != 0 && word + 1 < m_words.size())
+        bits |= m_words[word + 1] >> (64 - offset);
+
+    code = bits >> (64 - 2*k);
+    return true;
+}
+
+std::string PackedSequence::substr(const size_t pos, size_t len) const
+{
+    if (pos >= m_size)
+        return std::string();
+
+    len = std::min(len, m_size - pos);
+    std::string output(len, 'A');
+    for (size_t i = 0; i < len; i++)
+        output[i] = (*this)[pos + i];
+
+    return output;
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
@@ -0,0 +1,187 @@
+#ifndef LIB_PACKEDSEQ_H
+#define LIB_PACKEDSEQ_H
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "global.h"
+#include "kmer.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+class KmerRange;
+
+/*!
+    \brief Nucleotide sequence stored with 2 bits per base.
+
+    Bases are packed 32 per 64-bit word, the first base in the most
+    significant bits, so a word holds exactly the PatternToNumber() code of
+    its 32 bases. Every non-ACGT symbol (N, IUPAC codes, ...) is stored as
+    'A' and flagged in a side bitmap with 1 bit per base; it reads back as
+    'N'. Soft-masking (lowercase) is not kept.
+
+    Compared to ASCII text this uses a quarter of the memory, and k-mer codes
+    are extracted with shifts and masks instead of table lookups.
+ */
+class PackedSequence {
+
+public:
+    PackedSequence() = default;
+    explicit PackedSequence(const std::string_view seq);
+
+    void append(const std::string_view seq);
+    void clear() noexcept;
+    void reserve(const size_t n);
+
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    bool hasAmbiguous() const noexcept { return m_ambiguous != 0; }
+
+    int code(const size_t i) const noexcept
+    {
+        return (m_words[i >> 5] >> (62 - 2*(i & 31))) & 3;
+    }
+
+    bool isAmbiguous(const size_t i) const noexcept
+    {
+        return (m_ambiguous_mask[i >> 6] >> (i & 63)) & 1;
+    }
+
+    char operator[](const size_t i) const noexcept
+    {
+        return isAmbiguous(i) ? 'N' : INT_TO_BASE[code(i)];
+    }
+
+    bool kmer(const size_t pos, const int k, hash_t &code) const noexcept;
+    std::string substr(const size_t pos, size_t len = std::string::npos) const;
+    std::string toString() const { return substr(0); }
+
+    KmerRange kmers(const int k) const;
+
+private:
+    bool anyAmbiguous(const size_t pos, const size_t len) const noexcept;
+
+    std::vector<uint64_t> m_words;
+    std::vector<uint64_t> m_ambiguous_mask;
+    size_t m_size = 0;
+    size_t m_ambiguous = 0;
+};
+
+/*!
+    \brief A k-mer visited by KmerIterator.
+ */
+struct Kmer {
+    size_t position;
+    hash_t forward;
+    hash_t reverse;
+
+    hash_t canonical() const noexcept { return forward < reverse ? forward : reverse; }
+};
+
+/*!
+    \brief Forward iterator over the k-mers of a PackedSequence.
+
+    Each step shifts one base into a RollingKmer, so it costs O(1) whatever
+    \a k is. k-mers overlapping an ambiguous base are skipped.
+ */
+class KmerIterator {
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Kmer;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Kmer *;
+    using reference = const Kmer &;
+
+    KmerIterator(const PackedSequence *seq, const int k, const size_t pos) noexcept
+        : m_seq(seq), m_rolling(k), m_pos(pos)
+    {
+        advance();
+    }
+
+    reference operator*() const noexcept { return m_kmer; }
+    pointer operator->() const noexcept { return &m_kmer; }
+
+    KmerIterator &operator++() noexcept
+    {
+        advance();
+        return *this;
+    }
+
+    KmerIterator operator++(int) noexcept
+    {
+        KmerIterator tmp = *this;
+        advance();
+        return tmp;
+    }
+
+    bool operator==(const KmerIterator &other) const noexcept { return m_pos == other.m_pos && m_done == other.m_done; }
+    bool operator!=(const KmerIterator &other) const noexcept { return !(*this == other); }
+
+private:
+    void advance() noexcept
+    {
+        const size_t size = m_seq->size();
+        bool ambiguous = m_seq->hasAmbiguous();
+        while (m_pos < size) {
+            if (ambiguous && m_seq->isAmbiguous(m_pos)) {
+                m_rolling.reset();
+            } else {
+                m_rolling.push(m_seq->code(m_pos));
+            }
+
+            ++m_pos;
+            if (m_rolling.ready()) {
+                m_kmer.position = m_pos - m_rolling.k();
+                m_kmer.forward = m_rolling.forward();
+                m_kmer.reverse = m_rolling.reverse();
+                return;
+            }
+        }
+
+        m_done = true;
+    }
+
+    const PackedSequence *m_seq;
+    RollingKmer m_rolling;
+    size_t m_pos;
+    bool m_done = false;
+    Kmer m_kmer{0, 0, 0};
+};
+
+/*!
+    \brief All k-mers of a PackedSequence, for use in range-based for loops.
+
+    \code
+    for (const auto &kmer : seq.kmers(k))
+        ++freq_array[kmer.forward];
+    \endcode
+ */
+class KmerRange {
+
+public:
+    KmerRange(const PackedSequence *seq, const int k) noexcept
+        : m_seq(seq), m_k(k)
+    {
+
+    }
+
+    KmerIterator begin() const noexcept { return KmerIterator(m_seq, m_k, 0); }
+    KmerIterator end() const noexcept { return KmerIterator(m_seq, m_k, m_seq->size()); }
+
+private:
+    const PackedSequence *m_seq;
+    int m_k;
+};
+
+inline KmerRange PackedSequence::kmers(const int k) const
+{
+    return KmerRange(this, k);
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_PACKEDSEQ_H
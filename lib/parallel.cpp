@@ -0,0 +1,46 @@
+#include "parallel.h"
+
+#include <algorithm>
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(utils)
+
+/*!
+    Resolve the requested number of \a threads: a value less than 1 means
+    one thread per hardware thread.
+ */
+int ThreadCount(const int threads) noexcept
+{
+    if (threads > 0)
+        return threads;
+
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : static_cast<int>(hardware);
+}
+
+/*!
+    Split \a text into at most \a n shards overlapping by \a overlap bytes.
+
+    Each substring of length \a overlap + 1 (a k-mer when \a overlap is
+    k - 1) starts in exactly one shard and lies entirely inside it, so
+    scanning every shard independently visits each k-mer exactly once.
+    Shards are returned in text order.
+ */
+std::vector<std::string_view> SplitShards(
+    const std::string_view text, const size_t n, const size_t overlap)
+{
+    std::vector<std::string_view> shards;
+    if (text.length() <= overlap || n == 0)
+        return shards;
+
+    // Number of substring starting positions to distribute.
+    size_t starts = text.length() - overlap;
+    size_t step = (starts + n - 1) / n;
+    for (size_t begin = 0; begin < starts; begin += step) {
+        size_t count = std::min(step, starts - begin);
+        shards.push_back(text.substr(begin, count + overlap));
+    }
+
+    return shards;
+}
+
+BIOUTILS_END_SUB_NAMESPACE(utils)
@@ -0,0 +1,64 @@
+#ifndef LIB_PARALLEL_H
+#define LIB_PARALLEL_H
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "global.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(utils)
+
+int ThreadCount(const int threads) noexcept;
+std::vector<std::string_view> SplitShards(
+    const std::string_view text, const size_t n, const size_t overlap);
+
+/*!
+    Call \a fn(i) for each \a i in [0, \a n) on \a threads threads. Tasks
+    are handed out one by one, so uneven tasks are balanced. The calling
+    thread takes part in the work. The first exception thrown by a task is
+    rethrown after all threads have been joined.
+ */
+template <typename Fn>
+void ParallelFor(const size_t n, int threads, Fn fn)
+{
+    threads = ThreadCount(threads);
+    if (threads <= 1 || n <= 1) {
+        for (size_t i = 0; i < n; i++)
+            fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto work = [&]() {
+        for (size_t i; (i = next++) < n; ) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads && t < static_cast<int>(n); t++)
+        workers.emplace_back(work);
+    work();
+
+    for (auto &worker : workers)
+        worker.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+BIOUTILS_END_SUB_NAMESPACE(utils)
+
+#endif // LIB_PARALLEL_H
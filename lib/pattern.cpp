@@ -10,6 +10,10 @@
 
 #include "exceptions.h"
 #include "utils.h"
+#include "parallel.h"
+#include "hamming.h"
+#include "search.h"
+#include "skew.h"
 
 using namespace std;
 using namespace bioutils::utils;
@@ -23,18 +27,6 @@ static inline bool isPatternValid(const size_t seq_len, const size_t pattern_len
     return seq_len != 0 && pattern_len > 0 && pattern_len <= seq_len;
 }
 
-static const char INT_TO_BASE[4] = {'A', 'C', 'G', 'T'};
-
-static const int BASE_TO_INT[256] = {
-    REPEAT_LIST_N(-1, 60), REPEAT_LIST_N(-1, 5),
-//  A,  B, C,  D,  E,  F, G,  H,  I,  J,  K,  L,  M,  N,  O,  P,  Q,  R,  S, T,  U,  V,  W,  X,  Y,  Z
-    0, -1, 1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1,
-    REPEAT_LIST_N(-1, 6),
-//  a,  b, c,  d,  e,  f, g,  h,  i,  j,  k,  l,  m,  n,  o,  p,  q,  r,  s, t,  u,  v,  w,  x,  y,  z
-    0, -1, 1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1,
-    REPEAT_LIST_N(-1, 100), REPEAT_LIST_N(-1, 30), REPEAT_LIST_N(-1, 3)
-};
-
 /*!
     \brief Convert DNA base to number
     
@@ -97,14 +89,9 @@ static inline char IntToNucleobase(const int i)
 void find_do(const std::string_view text, const std::string_view pattern,
     std::function<void(const size_t, const std::string_view, const std::string_view)> callback)
 {
-    size_t text_len = text.length();
-    size_t pattern_len = pattern.length();
-
-    for (size_t i = 0; i < SubstrCount(text_len, pattern_len); i++) {
-        if (text.substr(i, pattern_len) == pattern) {
-            callback(i, text, pattern);
-        }
-    }
+    ForEachMatch(text, pattern, [&](const size_t i) {
+        callback(i, text, pattern);
+    });
 }
 
 /*!
@@ -117,17 +104,35 @@ void find_do(const std::string_view text, const std::string_view pattern,
  */
 size_t PatternCount_BF(const std::string_view text, const std::string_view pattern)
 {
-    unsigned int count = 0;
+    size_t text_len = text.length();
+    size_t pattern_len = pattern.length();
 
-    find_do(text, pattern,
-        [&](const size_t i, const std::string_view, const std::string_view) {
+    if (!isPatternValid(text_len, pattern_len))
+        return 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < SubstrCount(text_len, pattern_len); i++) {
+        if (text.substr(i, pattern_len) == pattern)
             count++;
-        }
-    );
+    }
 
     return count;
 }
 
+/*!
+    Compute the Number of Times a Pattern Appears in a Text (ExactMatcher)
+
+    This version of PatternCount skips to candidate positions with the
+    vectorized filter or the q-gram Horspool shifts of ExactMatcher.
+ */
+size_t PatternCountByMatcher(const std::string_view text, const std::string_view pattern)
+{
+    if (!isPatternValid(text.length(), pattern.length()))
+        return 0;
+
+    return ExactMatcher(pattern).count(text);
+}
+
 /*!
     Another brute force version of PatternCount.
  */
@@ -167,44 +172,95 @@ static size_t PatternCount_BFH(const std::string_view text, const std::string_vi
 #endif
 
 /*!
-    Compute the Number of Times a Pattern Appears in a Text (Rabin-Karp)
-
-    Compute the number of times a \a pattern appears in a \a text. This one is
-    implemented with Rabin-Karp algorithm. The max length of \a pattern is 32,
-    which can be hashed in to `long long` type.
+    Call \a fn(i) for every k-mer of \a text whose \a Rolling code equals
+    that of \a pattern, \a i being its starting position. With \a Verify,
+    for hashing encoders, the bases are compared when the codes are equal.
  */
-size_t PatternCount_RK(const std::string_view text, const std::string_view pattern)
+template <typename Rolling, bool Verify, typename Fn>
+static void ForEachRollingMatch(const std::string_view text, const std::string_view pattern, Fn fn)
 {
-    size_t t_len = text.length();
-    size_t p_len = pattern.length();
+    int k = static_cast<int>(pattern.length());
+    Rolling target(k);
+    for (char base : pattern) {
+        // A pattern with a non-ACGT byte never matches.
+        if (!target.push(base))
+            return;
+    }
 
-    if (!isPatternValid(t_len, p_len))
-        return 0;
+    Rolling rolling(k);
+    for (size_t i = 0; i < text.length(); i++) {
+        if (!rolling.push(text[i]) || !rolling.ready() || rolling.forward() != target.forward())
+            continue;
+
+        size_t start = i + 1 - k;
+        if (Verify) {
+            bool equal = true;
+            for (int j = 0; j < k && equal; j++) {
+                equal = BASE_TO_INT[static_cast<unsigned char>(text[start + j])]
+                    == BASE_TO_INT[static_cast<unsigned char>(pattern[j])];
+            }
+            if (!equal)
+                continue;
+        }
 
-    auto first_kmer = text.substr(0, p_len);
+        fn(start);
+    }
+}
 
-    // Check first k-mer
-    hash_t pattern_hash = PatternToNumber(pattern);
-    hash_t kmer_hash = PatternToNumber(first_kmer);
-    unsigned int count = kmer_hash == pattern_hash;
+/*!
+    Rabin-Karp search of \a pattern in \a text for any pattern length: the
+    exact 2-bit code in a hash_t up to 32 bases, in a hash128_t up to 64
+    bases, and a polynomial hash with verification beyond. Each base of
+    \a text is rolled in once, so the search stays linear.
 
-    hash_t mask = 0;
-    mask = ~((~mask) << (2*(p_len - 1)));
+    Bases are compared case-insensitively and a non-ACGT byte (N or any
+    IUPAC code) restarts the window, so k-mers containing one never match.
+ */
+template <typename Fn>
+static void ForEachRabinKarpMatch(const std::string_view text, const std::string_view pattern, Fn fn)
+{
+    if (!isPatternValid(text.length(), pattern.length()))
+        return;
+
+    if (pattern.length() <= static_cast<size_t>(RollingKmer::MAX_K))
+        ForEachRollingMatch<RollingKmer, false>(text, pattern, fn);
+    else if (pattern.length() <= static_cast<size_t>(RollingKmer128::MAX_K))
+        ForEachRollingMatch<RollingKmer128, false>(text, pattern, fn);
+    else
+        ForEachRollingMatch<RollingKmerHash, true>(text, pattern, fn);
+}
 
-    int base;
-    for (int i = 1; i < SubstrCount(t_len, p_len); i++) {
-        base = BASE_TO_INT[text[i+ p_len - 1]];
-        if (base == -1) throw UnknownNucleotideError(base);
-        // Compute hash of next k-mer
-        kmer_hash = ((kmer_hash & mask) << 2) | base;
-        // If hash values are matched then k-mer and pattern are matched.
-        if (kmer_hash == pattern_hash)
-            count++;
-    }
+/*!
+    Compute the Number of Times a Pattern Appears in a Text (Rabin-Karp)
+
+    Compute the number of times a \a pattern appears in a \a text. This one is
+    implemented with Rabin-Karp algorithm, see ForEachRabinKarpMatch(), and
+    handles patterns of any length.
+ */
+size_t PatternCount_RK(const std::string_view text, const std::string_view pattern)
+{
+    size_t count = 0;
+    ForEachRabinKarpMatch(text, pattern, [&count](const size_t) {
+        count++;
+    });
 
     return count;
 }
 
+/*!
+    Find all occurrences of a \a pattern in a \a text with Rabin-Karp, under
+    the same rules as PatternCount_RK().
+ */
+std::vector<size_t> PatternIndex_RK(const std::string_view text, const std::string_view pattern)
+{
+    std::vector<size_t> output;
+    ForEachRabinKarpMatch(text, pattern, [&output](const size_t i) {
+        output.push_back(i);
+    });
+
+    return output;
+}
+
 /*!
     Find the number of times that a k-mer appears as a substring of text.
  */
@@ -213,11 +269,13 @@ size_t  PatternCount(const std::string_view text, const std::string_view pattern
     switch (algo)
     {
     case AlgorithmEfficiency::Slow:
-    case AlgorithmEfficiency::Fast:
         return PatternCount_BF(text, pattern);
         break;
-    case AlgorithmEfficiency::Faster:
+    case AlgorithmEfficiency::Fast:
     case AlgorithmEfficiency::Fastest:
+        return PatternCountByMatcher(text, pattern);
+        break;
+    case AlgorithmEfficiency::Faster:
         return PatternCount_RK(text, pattern);
         break;
     default:
@@ -235,20 +293,106 @@ std::vector<size_t> PatternIndex(const std::string_view text, const std::string_
     if (!isPatternValid(text.length(), pattern.length()))
         return std::vector<size_t>();
     std::vector<size_t> output;
-    find_do(text, pattern,
-        [&](const size_t i, const std::string_view, const std::string_view){
-            output.push_back(i);
-        }
-    );
+    ForEachMatch(text, pattern, [&output](const size_t i) {
+        output.push_back(i);
+    });
+    return output;
+}
+
+/*!
+    Split \a text into shards overlapping by \a pattern_length - 1 bytes, so
+    that each occurrence lies entirely inside the one shard where it starts.
+    A few shards per thread balance the load, but shards are kept long
+    enough for the scan to outweigh starting a thread.
+ */
+static std::vector<std::string_view> SearchShards(const std::string_view text, const size_t pattern_length, const int threads)
+{
+    const size_t MIN_SHARD_LENGTH = 1 << 16;
+
+    size_t n = 4 * ThreadCount(threads);
+    n = std::max<size_t>(1, std::min(n, text.length() / MIN_SHARD_LENGTH));
+    return SplitShards(text, n, pattern_length - 1);
+}
+
+/*!
+    With several \a threads, shards of \a text are counted in parallel and
+    the counts summed. The result is the same as with one thread.
+ */
+size_t PatternCount(const std::string_view text, const std::string_view pattern, AlgorithmEfficiency algo, const int threads)
+{
+    if (ThreadCount(threads) <= 1 || !isPatternValid(text.length(), pattern.length()))
+        return PatternCount(text, pattern, algo);
+
+    auto shards = SearchShards(text, pattern.length(), threads);
+    std::vector<size_t> counts(shards.size(), 0);
+    ParallelFor(shards.size(), threads, [&](const size_t i) {
+        counts[i] = PatternCount(shards[i], pattern, algo);
+    });
+
+    size_t count = 0;
+    for (auto c : counts)
+        count += c;
+    return count;
+}
+
+/*!
+    With several \a threads, shards of \a text are searched in parallel and
+    their positions, already sorted, are concatenated in text order. The
+    result is the same as with one thread.
+ */
+std::vector<size_t> PatternIndex(const std::string_view text, const std::string_view pattern, const int threads)
+{
+    if (ThreadCount(threads) <= 1 || !isPatternValid(text.length(), pattern.length()))
+        return PatternIndex(text, pattern);
+
+    auto shards = SearchShards(text, pattern.length(), threads);
+    std::vector<std::vector<size_t>> positions(shards.size());
+    ParallelFor(shards.size(), threads, [&](const size_t i) {
+        size_t offset = shards[i].data() - text.data();
+        positions[i] = PatternIndex(shards[i], pattern);
+        for (auto &p : positions[i])
+            p += offset;
+    });
+
+    std::vector<size_t> output;
+    size_t total = 0;
+    for (const auto &p : positions)
+        total += p.size();
+    output.reserve(total);
+    for (const auto &p : positions)
+        output.insert(output.end(), p.begin(), p.end());
+
     return output;
 }
 
+/*!
+    2-bit code of the upper case bases A, C, G and T, and -1 for every other
+    byte, lower case included, so that packed codes compare like bytes.
+ */
+static inline int StrictBaseCode(const char base) noexcept
+{
+    switch (base) {
+    case 'A': return 0;
+    case 'C': return 1;
+    case 'G': return 2;
+    case 'T': return 3;
+    default:  return -1;
+    }
+}
+
 /*!
     \brief Find All Approximate Occurrences of a Pattern in a String
 
     We say that a k-mer \a pattern appears as a substring of \a text with at
     most \a d mismatches if there is some k-mer substring pattern2 of \a text
     having \a d or fewer mismatches with \a pattern, i.e., HammingDistance(pattern, pattern2) ≤ d.
+
+    When \a pattern is made of upper case ACGT bases, it is packed 2 bits
+    per base into one word per 32 bases, and the window of \a text ending
+    at each position is rolled into the same layout. Mismatches are then
+    counted by XOR and popcount a word at a time, stopping as soon as they
+    exceed \a d. Windows holding any other byte, and other patterns, are
+    compared byte by byte with CountMismatches().
  */
 std::vector<size_t> PatternIndexApproximate(const std::string_view text, const std::string_view pattern, const size_t d)
 {
@@ -256,10 +400,220 @@ std::vector<size_t> PatternIndexApproximate(const std::string_view text, const s
     size_t pattern_len = pattern.length();
 
     std::vector<size_t> output;
-    for (size_t i = 0; i < SubstrCount(text_len, pattern_len); i++) {
-        if (HammingDistance(text.substr(i, pattern_len), pattern) <= d) {
-            output.push_back(i);
+    if (!isPatternValid(text_len, pattern_len))
+        return output;
+
+    bool packable = std::all_of(pattern.begin(), pattern.end(),
+        [](const char c) { return StrictBaseCode(c) >= 0; });
+    if (!packable) {
+        for (size_t i = 0; i < SubstrCount(text_len, pattern_len); i++) {
+            if (CountMismatches(text.data() + i, pattern.data(), pattern_len, d) <= d)
+                output.push_back(i);
         }
+        return output;
+    }
+
+    // Word 0 holds the first (pattern_len - 1) % 32 + 1 bases, every other
+    // word 32 bases, each base in the same bits for pattern and window.
+    size_t n_words = (pattern_len + 31) / 32;
+    size_t head_bases = pattern_len - 32 * (n_words - 1);
+    hash_t head_mask = head_bases == 32 ? ~hash_t(0) : (hash_t(1) << 2*head_bases) - 1;
+
+    std::vector<hash_t> packed(n_words, 0), window(n_words, 0);
+    for (size_t i = 0; i < pattern_len; i++) {
+        size_t w = i < head_bases ? 0 : 1 + (i - head_bases) / 32;
+        packed[w] = (packed[w] << 2) | StrictBaseCode(pattern[i]);
+    }
+
+    // Position after the last byte which is not an upper case base.
+    size_t clean_from = 0;
+
+    if (n_words == 1) {
+        // The common case of a pattern of up to 32 bases, kept in registers.
+        hash_t code_window = 0;
+        for (size_t i = 0; i < text_len; i++) {
+            int code = StrictBaseCode(text[i]);
+            if (code < 0) {
+                clean_from = i + 1;
+                code = 0;
+            }
+            code_window = ((code_window << 2) | code) & head_mask;
+
+            if (i + 1 < pattern_len)
+                continue;
+
+            size_t start = i + 1 - pattern_len;
+            size_t mismatches = start >= clean_from
+                ? PackedMismatches(code_window, packed[0])
+                : CountMismatches(text.data() + start, pattern.data(), pattern_len, d);
+            if (mismatches <= d)
+                output.push_back(start);
+        }
+        return output;
+    }
+
+    for (size_t i = 0; i < text_len; i++) {
+        int code = StrictBaseCode(text[i]);
+        if (code < 0) {
+            clean_from = i + 1;
+            code = 0;
+        }
+
+        for (size_t w = 0; w + 1 < n_words; w++)
+            window[w] = (window[w] << 2) | (window[w + 1] >> 62);
+        window[n_words - 1] = (window[n_words - 1] << 2) | code;
+        window[0] &= head_mask;
+
+        if (i + 1 < pattern_len)
+            continue;
+
+        size_t start = i + 1 - pattern_len;
+        size_t mismatches = 0;
+        if (start >= clean_from) {
+            for (size_t w = 0; w < n_words && mismatches <= d; w++)
+                mismatches += PackedMismatches(window[w], packed[w]);
+        } else {
+            mismatches = CountMismatches(text.data() + start, pattern.data(), pattern_len, d);
+        }
+
+        if (mismatches <= d)
+            output.push_back(start);
+    }
+
+    return output;
+}
+
+typedef uint64_t word_t;
+static const size_t WORD_BITS = 64;
+
+/*!
+    Match masks of \a pattern for the bit-parallel searches: bit \c i of
+    word \c b of the mask of byte \c c is set when pattern[64b + i] is \c c.
+    Bytes are compared as they are, like HammingDistance() does.
+ */
+static std::vector<word_t> PatternMasks(const std::string_view pattern, const size_t n_words)
+{
+    std::vector<word_t> masks(256 * n_words, 0);
+    for (size_t i = 0; i < pattern.length(); i++) {
+        auto c = static_cast<unsigned char>(pattern[i]);
+        masks[c * n_words + i / WORD_BITS] |= word_t(1) << (i % WORD_BITS);
+    }
+
+    return masks;
+}
+
+/*!
+    \brief Find approximate occurrences of a pattern with shift-and.
+
+    Return the same positions as PatternIndexApproximate() for any bytes, by
+    the shift-and algorithm extended to mismatches (Wu and Manber). Bit \c i
+    of state \c R_j is set when the \c i + 1 bases of \a pattern ending at
+    the current position of \a text match with at most \c j mismatches, and
+    each state is updated a 64-bit word at a time, so the search costs
+    O(n (d + 1) ceil(m / 64)) whatever the alphabet.
+ */
+std::vector<size_t> PatternIndexApproximateShiftAnd(const std::string_view text, const std::string_view pattern, size_t d)
+{
+    std::vector<size_t> output;
+    size_t m = pattern.length();
+    if (!isPatternValid(text.length(), m))
+        return output;
+
+    d = std::min(d, m);
+    size_t n_words = (m + WORD_BITS - 1) / WORD_BITS;
+    auto masks = PatternMasks(pattern, n_words);
+
+    // d + 1 states of n_words words, R_j starting at j * n_words.
+    std::vector<word_t> states((d + 1) * n_words, 0);
+    word_t last_bit = word_t(1) << ((m - 1) % WORD_BITS);
+
+    for (size_t i = 0; i < text.length(); i++) {
+        const word_t *mask = &masks[static_cast<unsigned char>(text[i]) * n_words];
+
+        // R_j uses the previous R_(j-1), so update from j = d downwards.
+        for (size_t j = d + 1; j-- > 0; ) {
+            word_t *state = &states[j * n_words];
+            const word_t *fewer = j > 0 ? &states[(j - 1) * n_words] : nullptr;
+            word_t carry = 1, fewer_carry = 1;
+            for (size_t w = 0; w < n_words; w++) {
+                word_t shifted = (state[w] << 1) | carry;
+                carry = state[w] >> (WORD_BITS - 1);
+                state[w] = shifted & mask[w];
+                if (fewer) {
+                    state[w] |= (fewer[w] << 1) | fewer_carry;
+                    fewer_carry = fewer[w] >> (WORD_BITS - 1);
+                }
+            }
+        }
+
+        if (i + 1 >= m && (states[d * n_words + n_words - 1] & last_bit))
+            output.push_back(i + 1 - m);
+    }
+
+    return output;
+}
+
+/*!
+    \brief Find occurrences of a pattern within an edit distance.
+
+    Return the end position, i.e. the index of the last base, of every
+    substring of \a text within edit distance \a d of \a pattern, counting
+    mismatches, insertions and deletions. The start of such a substring is
+    not unique, so only its end is reported.
+
+    The edit distance column of each text position is kept as vertical
+    delta bit-vectors and advanced with Myers' bit-parallel algorithm, in
+    blocks of 64 rows as described by Hyyrö, so the search costs
+    O(n ceil(m / 64)) whatever \a d is.
+ */
+std::vector<size_t> PatternIndexEditDistance(const std::string_view text, const std::string_view pattern, const size_t d)
+{
+    std::vector<size_t> output;
+    size_t m = pattern.length();
+    // Unlike exact matches, a pattern longer than the text may match.
+    if (text.empty() || m == 0)
+        return output;
+
+    size_t n_words = (m + WORD_BITS - 1) / WORD_BITS;
+    auto masks = PatternMasks(pattern, n_words);
+
+    // Column 0 holds D[i][0] = i, i.e. +1 vertical deltas, and a match may
+    // start anywhere, so row 0 stays zero.
+    std::vector<word_t> plus(n_words, ~word_t(0)), minus(n_words, 0);
+    size_t score = m;
+    const word_t high_bit = word_t(1) << (WORD_BITS - 1);
+    const word_t last_bit = word_t(1) << ((m - 1) % WORD_BITS);
+
+    for (size_t i = 0; i < text.length(); i++) {
+        const word_t *mask = &masks[static_cast<unsigned char>(text[i]) * n_words];
+
+        int h_in = 0;
+        for (size_t w = 0; w < n_words; w++) {
+            word_t Pv = plus[w], Mv = minus[w];
+            word_t Eq = mask[w];
+            word_t h_in_neg = h_in < 0 ? 1 : 0;
+
+            word_t Xv = Eq | Mv;
+            Eq |= h_in_neg;
+            word_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+            word_t Ph = Mv | ~(Xh | Pv);
+            word_t Mh = Pv & Xh;
+
+            // Horizontal delta leaving the block, taken at row m in the
+            // last block since the rows above it are padding.
+            word_t out_bit = w + 1 == n_words ? last_bit : high_bit;
+            int h_out = (Ph & out_bit) ? 1 : (Mh & out_bit) ? -1 : 0;
+
+            Ph = (Ph << 1) | (h_in > 0 ? 1 : 0);
+            Mh = (Mh << 1) | h_in_neg;
+            plus[w] = Mh | ~(Xv | Ph);
+            minus[w] = Ph & Xv;
+            h_in = h_out;
+        }
+
+        score += h_in;
+        if (score <= d)
+            output.push_back(i);
     }
 
     return output;
@@ -271,26 +625,31 @@ std::vector<size_t> PatternIndexApproximate(const std::string_view text, const s
  * @param text Text to search
  * @param k Length of k-mer
  * @param algo Choose an algorithms
+ * @param threads Number of counting threads, less than 1 means all cores.
  * @return std::set<std::string> All most frequent k-mers in text.
  */
 std::set<std::string> FrequentWords(
-    const std::string_view text, const int k, AlgorithmEfficiency algo /*= Slow*/)
+    const std::string_view text, const int k, AlgorithmEfficiency algo /*= Slow*/,
+    const int threads /*= 1*/)
 {
     switch (algo)
     {
     case AlgorithmEfficiency::Slow:
         return FrequentWordsSlow(text, k);
     case AlgorithmEfficiency::Fast:
-        return FrequentWordsByPerfectHash(text, k);
+        return FrequentWordsByPerfectHash(text, k, threads);
     case AlgorithmEfficiency::Faster:
-        return FrequentWordsBySorting(text, k);
+        return FrequentWordsBySorting(text, k, threads);
     case AlgorithmEfficiency::Fastest:
-        return FrequentWordsByStdHash(text, k);
+        return FrequentWordsByStdHash(text, k, threads);
     default:
-        break;
+    {
+        if (k <= MAX_HASHABLE_LENGTH)
+            return FrequentWordsByKmerCounter(text, k, threads);
+        else
+            return FrequentWordsByStdHash(text, k, threads);
+    }
     }
-
-    return std::set<std::string>();
 }
 
 std::set<std::string>
@@ -337,14 +696,40 @@ FrequentWordsSlow(const std::string_view text, const int k)
 /*!
     \brief Find the Most Frequent Words in a String
     
-    This version of FrequentWords is implemented with FrequencyTable()
+    This version of FrequentWords is implemented with FrequencyTable(). k-mers
+    up to KmerTable128::MAX_K bases are counted by their packed code, longer
+    ones by string.
  */
 std::set<std::string> FrequentWordsByStdHash(const std::string_view text, const int k)
+{
+    return FrequentWordsByStdHash(text, k, 1);
+}
+
+template <typename Table>
+static std::set<std::string> MostFrequentInTable(const Table &table)
+{
+    uint max = table.max();
+
+    std::set<std::string> max_freq;
+    table.forEach([&](const std::string &kmer, const uint count) {
+        if (count == max)
+            max_freq.emplace(kmer);
+    });
+
+    return max_freq;
+}
+
+std::set<std::string> FrequentWordsByStdHash(const std::string_view text, const int k, const int threads)
 {
     if (!isPatternValid(text.length(), k))
         return std::set<std::string>();
 
-    auto kmer_freq_table = FrequencyTable(text, k);
+    if (k <= KmerTable::MAX_K)
+        return MostFrequentInTable(KmerTable(text, k, threads));
+    else if (k <= KmerTable128::MAX_K)
+        return MostFrequentInTable(KmerTable128(text, k, threads));
+
+    auto kmer_freq_table = FrequencyTable(text, k, threads);
     size_t max = MaxMap(kmer_freq_table);
 
     std::set<std::string> max_freq;
@@ -362,11 +747,16 @@ std::set<std::string> FrequentWordsByStdHash(const std::string_view text, const
     This version of FrequentWords is implemented with FrequencyArray()
  */
 std::set<std::string> FrequentWordsByPerfectHash(const std::string_view text, const int k)
+{
+    return FrequentWordsByPerfectHash(text, k, 1);
+}
+
+std::set<std::string> FrequentWordsByPerfectHash(const std::string_view text, const int k, const int threads)
 {
     if (!isPatternValid(text.length(), k))
         return std::set<std::string>();
 
-    auto freq_array = FrequencyArray(text, k);
+    auto freq_array = FrequencyArray(text, k, threads);
     size_t max = MaxArray(freq_array);
 
     std::set<std::string> max_freq;
@@ -384,6 +774,136 @@ std::set<std::string> FrequentWordsByPerfectHash(const std::string_view text, co
     return max_freq;
 }
 
+/*!
+    \brief Find the Most Frequent Words in a String
+
+    This version of FrequentWords is implemented with CountKmers(), so the
+    counting backend is picked from \a k: a dense array for small \a k and
+    a hash table of k-mer codes sized to the distinct k-mers otherwise.
+ */
+std::set<std::string> FrequentWordsByKmerCounter(const std::string_view text, const int k, const int threads)
+{
+    if (!isPatternValid(text.length(), k))
+        return std::set<std::string>();
+
+    auto counter = CountKmers(text, k, threads);
+    uint max = counter.max();
+
+    std::set<std::string> max_freq;
+    counter.forEach([&](const hash_t code, const uint count) {
+        if (count == max)
+            max_freq.insert(NumberToPatternBitwise(code, k));
+    });
+
+    return max_freq;
+}
+
+/*!
+    Spell out the codes of \a entries as k-mers, keeping their order.
+ */
+static std::vector<std::pair<std::string, uint>> SpellEntries(
+    const std::vector<std::pair<hash_t, uint>> &entries, const int k)
+{
+    std::vector<std::pair<std::string, uint>> output;
+    output.reserve(entries.size());
+    for (const auto &entry : entries)
+        output.emplace_back(NumberToPatternBitwise(entry.first, k), entry.second);
+    return output;
+}
+
+/*!
+    Sort \a entries by decreasing count, and by increasing key among equal
+    counts, the order of TopCounts::take().
+ */
+template <typename Key>
+static void SortByCount(std::vector<std::pair<Key, uint>> &entries)
+{
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+}
+
+/*!
+    \brief Find the \a n most frequent k-mers of \a text with their counts.
+
+    Unlike FrequentWords(), which only returns the k-mers of the maximum
+    count, this ranks all k-mers by decreasing count, and in lexicographic
+    order among equal counts, and keeps the first \a n of them, so a tie
+    at the n-th count is cut. They are selected by a TopCounts heap of \a n
+    entries while the counts are scanned, so only the k-mers returned are
+    ever spelled out.
+
+    k-mers up to MAX_HASHABLE_LENGTH are counted by CountKmers(), up to
+    KmerTable128::MAX_K by a KmerTable128 and longer ones by
+    FrequencyTable().
+ */
+std::vector<std::pair<std::string, uint>> TopFrequentWords(
+    const std::string_view text, const int k, const size_t n, const int threads)
+{
+    if (!isPatternValid(text.length(), k) || n == 0)
+        return std::vector<std::pair<std::string, uint>>();
+
+    if (k <= MAX_HASHABLE_LENGTH) {
+        TopCounts<hash_t> top(n);
+        CountKmers(text, k, threads).forEach([&top](const hash_t code, const uint count) {
+            top.add(code, count);
+        });
+        return SpellEntries(top.take(), k);
+    }
+
+    TopCounts<std::string> top(n);
+    if (k <= KmerTable128::MAX_K) {
+        KmerTable128(text, k, threads).forEach([&top](const std::string &kmer, const uint count) {
+            top.add(kmer, count);
+        });
+    } else {
+        for (const auto &p : FrequencyTable(text, k, threads))
+            top.add(p.first, p.second);
+    }
+    return top.take();
+}
+
+/*!
+    \brief Find the k-mers of \a text occurring at least \a min_count times,
+    with their counts.
+
+    The counts reaching \a min_count are compacted out of the counter
+    before anything is sorted or spelled out, so a high threshold costs
+    little more than counting. The k-mers come in the order of
+    TopFrequentWords(), and are counted the same way.
+ */
+std::vector<std::pair<std::string, uint>> FrequentWordsAtLeast(
+    const std::string_view text, const int k, const uint min_count, const int threads)
+{
+    if (!isPatternValid(text.length(), k))
+        return std::vector<std::pair<std::string, uint>>();
+
+    if (k <= MAX_HASHABLE_LENGTH) {
+        std::vector<std::pair<hash_t, uint>> entries;
+        CountKmers(text, k, threads).forEach([&](const hash_t code, const uint count) {
+            if (count >= min_count)
+                entries.emplace_back(code, count);
+        });
+        SortByCount(entries);
+        return SpellEntries(entries, k);
+    }
+
+    std::vector<std::pair<std::string, uint>> entries;
+    if (k <= KmerTable128::MAX_K) {
+        KmerTable128(text, k, threads).forEach([&](const std::string &kmer, const uint count) {
+            if (count >= min_count)
+                entries.emplace_back(kmer, count);
+        });
+    } else {
+        for (const auto &p : FrequencyTable(text, k, threads)) {
+            if (p.second >= min_count)
+                entries.push_back(p);
+        }
+    }
+    SortByCount(entries);
+    return entries;
+}
+
 /*!
     \brief Find the Most Frequent Words in a String
     
@@ -393,47 +913,223 @@ std::set<std::string> FrequentWordsByPerfectHash(const std::string_view text, co
     clump together in the sorted array, frequent \a k -mer are the longest runs
     of identical pattern hash in sorted index.
 
-    This method is not as efficient as FrequentWordsByStdHash, because FrequencyTable
-    is implemented with std::unordered_map and is very efficient. The length of
-    FrequencyTable result will be shorter than "index/count" array of
-    FrequentWordsBySorting and then sorting index array also increases the
-    running time.
+    k-mer codes are integers of exactly 2k bits, so they are sorted by
+    RadixSort() in a few linear passes rather than by comparisons. Unlike a
+    hash table, which misses the cache on nearly every k-mer once it
+    outgrows it, every pass streams through the codes, so this is the
+    fastest way to count the k-mers of a large genome when \a k is too
+    large for FrequencyArray().
  */
 std::set<std::string> FrequentWordsBySorting(const std::string_view text, const int k)
+{
+    return FrequentWordsBySorting(text, k, 1);
+}
+
+/*!
+    With several \a threads, each shard of \a text is encoded on its own
+    thread, and RadixSort() shares out both the split of the codes by their
+    high bits and the sort of each part.
+ */
+std::set<std::string> FrequentWordsBySorting(const std::string_view text, const int k, const int threads)
 {
     if (!isPatternValid(text.length(), k))
         return std::set<std::string>();
 
-    size_t n_kmer = SubstrCount(text.length(), k);
+    // Each shard is encoded on its own thread, and the codes are gathered
+    // into index.
+    auto shards = SplitShards(text, ThreadCount(threads), k - 1);
+    std::vector<std::vector<hash_t>> codes(shards.size());
+    ParallelFor(shards.size(), threads, [&](const size_t i) {
+        codes[i].reserve(SubstrCount(shards[i].length(), k));
+        ForEachKmer(shards[i], k, [&](const size_t, const RollingKmer &kmer) {
+            codes[i].push_back(kmer.forward());
+        });
+    });
+
+    std::vector<hash_t> index = std::move(codes[0]);
+    std::vector<size_t> offsets(codes.size(), 0);
+    size_t total = index.size();
+    for (size_t i = 1; i < codes.size(); i++) {
+        offsets[i] = total;
+        total += codes[i].size();
+    }
+    index.resize(total);
+    ParallelFor(codes.size(), threads, [&](const size_t i) {
+        if (i > 0)
+            std::copy(codes[i].begin(), codes[i].end(), index.begin() + offsets[i]);
+    });
+
+    RadixSort(index, 2*k, threads);
+    if (index.empty())
+        return std::set<std::string>();
 
-    // `index` is the pattern hash of each k-mer in text.
-    std::vector<hash_t> index(n_kmer, 0);
-    for (size_t i = 0; i < n_kmer; i++)
-        index[i] = PatternToNumberBitwise(text.substr(i, k));
+    size_t n_kmer = index.size();
 
-    // Sorted with the default operator<
-    std::sort(index.begin(), index.end());
+    // Frequent k-mers are the longest runs of identical pattern hash in
+    // sorted index, measured in a first pass and collected in a second one
+    // rather than kept in a count per k-mer.
+    auto run_end = [&index, n_kmer](size_t i) {
+        hash_t code = index[i];
+        while (i < n_kmer && index[i] == code)
+            i++;
+        return i;
+    };
 
     size_t max = 1;
-    // Frequent k-mers are the longest runs of identical pattern hash in
-    // sorted index.
-    std::vector<size_t> count(n_kmer, 1);
-    for (size_t i = 1; i < n_kmer; i++) {
-        if (index[i] == index[i-1])
-            count[i] = count[i-1] + 1;
-        if (count[i] > max)
-            max = count[i];
+    for (size_t i = 0, j; i < n_kmer; i = j) {
+        j = run_end(i);
+        max = std::max(max, j - i);
     }
 
     std::set<std::string> max_freq;
-    for (int i = 0; i < n_kmer; i++) {
-        if (count[i] == max) {
-            max_freq.insert(
-                NumberToPatternBitwise(index[i], k)
-            );
+    for (size_t i = 0, j; i < n_kmer; i = j) {
+        j = run_end(i);
+        if (j - i == max)
+            max_freq.insert(NumberToPatternBitwise(index[i], k));
+    }
+
+    return max_freq;
+}
+
+/*!
+    Count the d-neighborhood of every k-mer of \a text with reverse
+    complements, keyed by canonical code, into \a counter.
+
+    The neighbors of the reverse complement of a k-mer are the reverse
+    complements of its neighbors, so only the forward neighborhood is
+    generated and each neighbor is counted under its canonical code. A
+    code then collects the counts of both strands, except a palindromic
+    code, which is its own reverse complement and must be doubled, see
+    CanonicalCount().
+ */
+template <typename Counter>
+static void CountCanonicalNeighbors(const std::string_view text, const int k, const int d, Counter &counter)
+{
+    ForEachKmer(text, k, [&](const size_t, const RollingKmer &kmer) {
+        ForEachNeighborPair(kmer.forward(), k, d, [&counter](const hash_t neighbor, const hash_t reverse) {
+            counter[neighbor < reverse ? neighbor : reverse]++;
+        });
+    });
+}
+
+/*!
+    Add \a count to the canonical code of every neighbor of \a code.
+ */
+static void AddCanonicalNeighbors(const hash_t code, const int k, const int d, const uint count, KmerCounter &counter)
+{
+    ForEachNeighborPair(code, k, d, [&counter, count](const hash_t neighbor, const hash_t reverse) {
+        counter.add(neighbor < reverse ? neighbor : reverse, count);
+    });
+}
+
+/*!
+    Canonical count of \a code from the \a count of its neighbors counted
+    under canonical codes, see CanonicalCode().
+ */
+static inline uint CanonicalCount(const hash_t code, const int k, const uint count) noexcept
+{
+    return ReverseComplementCode(code, k) == code ? 2 * count : count;
+}
+
+/*!
+    Find the most frequent words with mismatches on 2-bit codes end to end.
+
+    The k-mers of \a text are counted first, so that a k-mer repeated many
+    times has its neighborhood enumerated once, weighted by its count.
+    Neighborhoods are generated by ForEachNeighbor() into a KmerCounter,
+    which is a dense array for small \a k. With several \a threads, the
+    distinct k-mers are split between threads, each one counting into its
+    own KmerCounter, and the counters are merged.
+
+    With \a rev_comp, a hash table counts neighbors under their canonical
+    code as in FrequencyTableWithMismatches(), so the reverse complements
+    need no neighborhood of their own and the table is half the size. A
+    dense array has a cell for every code anyway, and canonical codes would
+    scatter the neighbors of a k-mer all over it, so there the reverse
+    complements are counted as k-mers of their own instead.
+
+    k-mers containing a non-ACGT byte are skipped. \a k above
+    MAX_HASHABLE_LENGTH falls back to FrequentWordsWithMismatches().
+ */
+std::set<std::string> FrequentWordsWithMismatchesByKmerCounter(
+    const std::string_view text, const int k, const int d, bool rev_comp, const int threads)
+{
+    if (!isPatternValid(text.length(), k))
+        return std::set<std::string>();
+
+    if (k > MAX_HASHABLE_LENGTH)
+        return FrequentWordsWithMismatches(text, k, d, rev_comp);
+
+    KmerCounter kmers = CountKmers(text, k, threads);
+    size_t expected = SubstrCount(text.length(), k) * NeighborCount(k, d);
+    bool canonical_keys = rev_comp && !KmerCounter::preferDense(k, expected);
+    if (rev_comp && !canonical_keys) {
+        KmerCounter both(k, 2 * SubstrCount(text.length(), k));
+        kmers.forEach([&both, k](const hash_t code, const uint count) {
+            both.add(code, count);
+            both.add(ReverseComplementCode(code, k), count);
+        });
+        kmers = std::move(both);
+    }
+
+    std::vector<std::pair<hash_t, uint>> distinct;
+    kmers.forEach([&distinct](const hash_t code, const uint count) {
+        distinct.emplace_back(code, count);
+    });
+    if (distinct.empty())
+        return std::set<std::string>();
+
+    // The neighborhoods of a share of the k-mers overlap, so their total
+    // size is only a bound: KmerCounter reserves no more than 4^k codes,
+    // and takes a dense array when a hash table would be larger.
+    size_t n = std::min<size_t>(ThreadCount(threads), distinct.size());
+    size_t step = (distinct.size() + n - 1) / n;
+    std::vector<KmerCounter> partial;
+    for (size_t i = 0; i < n; i++)
+        partial.emplace_back(k, std::min(step, distinct.size() - i * step) * NeighborCount(k, d));
+
+    ParallelFor(n, threads, [&](const size_t i) {
+        KmerCounter &counter = partial[i];
+        auto end = distinct.begin() + std::min(distinct.size(), (i + 1) * step);
+        for (auto it = distinct.begin() + i * step; it < end; ++it) {
+            uint count = it->second;
+            if (canonical_keys) {
+                AddCanonicalNeighbors(it->first, k, d, count, counter);
+                continue;
+            }
+            ForEachNeighbor(it->first, k, d, [&counter, count](const hash_t neighbor) {
+                counter.add(neighbor, count);
+            });
         }
+    });
+
+    for (size_t i = 1; i < partial.size(); i++)
+        partial[0].merge(partial[i]);
+
+    if (!canonical_keys) {
+        std::set<std::string> max_freq;
+        uint max = partial[0].max();
+        partial[0].forEach([&](const hash_t code, const uint count) {
+            if (count == max)
+                max_freq.insert(NumberToPatternBitwise(code, k));
+        });
+
+        return max_freq;
     }
 
+    uint max = 0;
+    partial[0].forEach([&max, k](const hash_t code, const uint count) {
+        max = std::max(max, CanonicalCount(code, k, count));
+    });
+
+    std::set<std::string> max_freq;
+    partial[0].forEach([&](const hash_t code, const uint count) {
+        if (CanonicalCount(code, k, count) == max) {
+            max_freq.insert(NumberToPatternBitwise(code, k));
+            max_freq.insert(NumberToPatternBitwise(ReverseComplementCode(code, k), k));
+        }
+    });
+
     return max_freq;
 }
 
@@ -441,12 +1137,18 @@ std::set<std::string> FrequentWordsBySorting(const std::string_view text, const
     \brief Find the Most Frequent Words with Mismatches in a String
 
     See https://rosalind.info/problems/ba1i/
+
+    k-mers up to MAX_HASHABLE_LENGTH bases are counted by
+    FrequentWordsWithMismatchesByKmerCounter().
  */
 std::set<std::string> FrequentWordsWithMismatches(const std::string_view text, const int k, const int d, bool rev_comp)
 {
     if (!isPatternValid(text.length(), k))
         return std::set<std::string>();
 
+    if (k <= MAX_HASHABLE_LENGTH)
+        return FrequentWordsWithMismatchesByKmerCounter(text, k, d, rev_comp);
+
     auto kmer_freq_table = FrequencyTableWithMismatches(text, k, d, rev_comp);
     size_t max = MaxMap(kmer_freq_table);
 
@@ -463,6 +1165,11 @@ std::set<std::string> FrequentWordsWithMismatches(const std::string_view text, c
     \brief Find the Most Frequent Words with Mismatches in a String
 
     See https://rosalind.info/problems/ba1i/
+
+    Every neighbor of every k-mer is held in the sorted index, which takes
+    8 bytes times the number of k-mers times NeighborCount(k, d), twice
+    with \a rev_comp: about 10 GB for 1 Mbp with k = 12 and d = 2. Use
+    FrequentWordsWithMismatches() beyond short texts.
  */
 std::set<std::string> FrequentWordsWithMismatchesBySorting(
     const std::string_view text, const int k, const int d, bool rev_comp)
@@ -472,9 +1179,20 @@ std::set<std::string> FrequentWordsWithMismatchesBySorting(
 
     size_t n_kmer = SubstrCount(text.length(), k);
 
+    vector<hash_t> index;
+    if (k <= MAX_HASHABLE_LENGTH) {
+        // Neighbors are generated as codes straight into the index.
+        index.reserve(n_kmer * NeighborCount(k, d) * (rev_comp ? 2 : 1));
+        ForEachKmer(text, k, [&](const size_t, const RollingKmer &kmer) {
+            Neighbors(kmer.forward(), k, d, index);
+            if (rev_comp)
+                Neighbors(kmer.reverse(), k, d, index);
+        });
+    }
+
     // 最大的不同在于，我们将生成的 Neighborhoods 当做所有在原始序列中出现过的 k-mer
     vector<string> neighborhoods;
-    for (size_t i = 0; i < n_kmer; i++) {
+    for (size_t i = 0; i < n_kmer && k > MAX_HASHABLE_LENGTH; i++) {
         auto kmer = text.substr(i, k);
         auto neighbors = NeighborsRecursive(kmer, d);
         neighborhoods.reserve(neighbors.size());
@@ -494,29 +1212,31 @@ std::set<std::string> FrequentWordsWithMismatchesBySorting(
 
     }
 
-    vector<hash_t> index(neighborhoods.size(), 0);
-    for (size_t i = 0; i < neighborhoods.size(); i++)
-        index[i] = PatternToNumberBitwise(neighborhoods[i]);
+    for (const auto &neighbor : neighborhoods)
+        index.push_back(PatternToNumberBitwise(neighbor));
 
-    std::sort(index.begin(), index.end());
+    RadixSort(index, std::min(2*k, 64));
 
-    size_t max = 1;
-    vector<size_t> count(index.size(), 1);
-    for (size_t i = 1; i < index.size(); i++) {
-        if (index[i] == index[i-1])
-            count[i] = count[i-1] + 1;
-        if (count[i] > max)
-            max = count[i];
-    }
+    // Equal codes are adjacent once sorted, so the runs are counted in
+    // place instead of in a count per entry.
+    auto forEachRun = [&index](auto fn) {
+        for (size_t i = 0, j = 0; i < index.size(); i = j) {
+            while (j < index.size() && index[j] == index[i])
+                j++;
+            fn(index[i], j - i);
+        }
+    };
+
+    size_t max = 0;
+    forEachRun([&max](const hash_t, const size_t count) {
+        max = std::max(max, count);
+    });
 
     std::set<std::string> max_freq;
-    for (int i = 0; i < count.size(); i++) {
-        if (count[i] == max) {
-            max_freq.insert(
-                NumberToPatternBitwise(index[i], k)
-            );
-        }
-    }
+    forEachRun([&](const hash_t code, const size_t count) {
+        if (count == max)
+            max_freq.insert(NumberToPatternBitwise(code, k));
+    });
 
     return max_freq;
 }
@@ -532,6 +1252,77 @@ std::set<std::string> FrequentWordsWithMismatchesBySorting(
  */
 std::unordered_map<std::string, uint> FrequencyTable(const std::string_view text, const int k)
 {
+    return FrequencyTable(text, k, 1);
+}
+
+template <typename Table>
+static std::unordered_map<std::string, uint> TableToMap(const Table &table)
+{
+    std::unordered_map<std::string, uint> output(table.size());
+    table.forEach([&output](const std::string &kmer, const uint count) {
+        output.emplace(kmer, count);
+    });
+
+    return output;
+}
+
+/*!
+    With several \a threads, each shard of \a text is counted into its own
+    table and the tables are then merged into the first one.
+
+    k-mers up to KmerTable128::MAX_K bases are counted in a KmerTable by
+    their packed code and only the distinct k-mers are turned into strings.
+    Callers which do not need a std::unordered_map should use KmerTable
+    directly. Longer k-mers are counted by string.
+ */
+std::unordered_map<std::string, uint> FrequencyTable(const std::string_view text, const int k, const int threads)
+{
+    return FrequencyTable(text, k, threads, false);
+}
+
+/*!
+    With \a canonical, a k-mer and its reverse complement are counted
+    together under the canonical k-mer, the smaller of the two, which is
+    the only one in the table. So the table is about half the size. Their
+    codes are rolled together, and only the distinct canonical k-mers are
+    turned into strings. Canonical k-mers are limited to
+    MAX_HASHABLE_LENGTH bases.
+ */
+std::unordered_map<std::string, uint> FrequencyTable(const std::string_view text, const int k, const int threads, bool canonical)
+{
+    if (canonical) {
+        if (!isPatternValid(text.length(), k))
+            return std::unordered_map<std::string, uint>();
+
+        KmerCounter counter = CountKmers(text, k, threads, true);
+        std::unordered_map<std::string, uint> output;
+        counter.forEach([&output, k](const hash_t code, const uint count) {
+            output.emplace(NumberToPatternBitwise(code, k), count);
+        });
+        return output;
+    }
+
+    if (isPatternValid(text.length(), k) && k <= KmerTable::MAX_K)
+        return TableToMap(KmerTable(text, k, threads));
+    else if (isPatternValid(text.length(), k) && k <= KmerTable128::MAX_K)
+        return TableToMap(KmerTable128(text, k, threads));
+
+    if (ThreadCount(threads) > 1 && isPatternValid(text.length(), k)) {
+        auto shards = SplitShards(text, ThreadCount(threads), k - 1);
+        std::vector<std::unordered_map<std::string, uint>> tables(shards.size());
+        ParallelFor(shards.size(), threads, [&](const size_t i) {
+            tables[i] = FrequencyTable(shards[i], k);
+        });
+
+        auto &output = tables[0];
+        for (size_t i = 1; i < tables.size(); i++) {
+            for (auto &p : tables[i])
+                output[p.first] += p.second;
+        }
+
+        return std::move(output);
+    }
+
     size_t t_len = text.length();
     size_t n_kmer = SubstrCount(t_len, k);
 
@@ -548,8 +1339,14 @@ std::unordered_map<std::string, uint> FrequencyTable(const std::string_view text
     return output;
 }
 
+/*!
+    With \a rev_comp, each k-mer also counts the k-mers within distance
+    \a d of its reverse complement. With \a canonical too, the table only
+    holds the canonical k-mer of each pair of reverse complements, the
+    smaller one, since both have the same count.
+ */
 unordered_map<string, uint> FrequencyTableWithMismatches(
-    const string_view text, const int k, const int d, bool rev_comp)
+    const string_view text, const int k, const int d, bool rev_comp, bool canonical)
 {
     size_t t_len = text.length();
     size_t n_kmer = SubstrCount(t_len, k);
@@ -557,6 +1354,43 @@ unordered_map<string, uint> FrequencyTableWithMismatches(
     if (!isPatternValid(t_len, k))
         return std::unordered_map<std::string, uint>();
 
+    if (canonical && (!rev_comp || k > MAX_HASHABLE_LENGTH))
+        throw std::runtime_error(
+            "Canonical k-mers need reverse complements and at most MAX_HASHABLE_LENGTH bases.");
+
+    if (k <= MAX_HASHABLE_LENGTH && rev_comp) {
+        FlatCounter<hash_t> counter;
+        CountCanonicalNeighbors(text, k, d, counter);
+
+        std::unordered_map<std::string, uint> output(canonical ? counter.size() : 2 * counter.size());
+        counter.forEach([&](const hash_t code, const uint count) {
+            uint total = CanonicalCount(code, k, count);
+            output.emplace(NumberToPatternBitwise(code, k), total);
+            if (!canonical)
+                output.emplace(NumberToPatternBitwise(ReverseComplementCode(code, k), k), total);
+        });
+
+        return output;
+    }
+
+    if (k <= MAX_HASHABLE_LENGTH) {
+        // Neighbors are counted by code, so the table holds no strings
+        // until the distinct neighbors are reported.
+        FlatCounter<hash_t> counter;
+        ForEachKmer(text, k, [&](const size_t, const RollingKmer &kmer) {
+            ForEachNeighbor(kmer.forward(), k, d, [&counter](const hash_t neighbor) {
+                counter[neighbor]++;
+            });
+        });
+
+        std::unordered_map<std::string, uint> output(counter.size());
+        counter.forEach([&](const hash_t code, const uint count) {
+            output.emplace(NumberToPatternBitwise(code, k), count);
+        });
+
+        return output;
+    }
+
     std::unordered_map<std::string, uint> output;
     for (int i = 0; i < n_kmer; i++) {
         // Neighborhood relationships are mutual. When one k-mer shows up,
@@ -580,6 +1414,48 @@ unordered_map<string, uint> FrequencyTableWithMismatches(
     return output;
 }
 
+/*!
+    Count every k-mer of \a text into a KmerCounter, which picks a dense
+    array or a hash table from \a k. With several \a threads, shards of
+    \a text are counted into their own KmerCounter and merged.
+
+    With \a canonical, each k-mer is counted under its canonical code,
+    together with its reverse complement, and a palindrome counts twice,
+    see CanonicalCode().
+
+    k-mers containing a non-ACGT byte are not counted. \a k is limited to
+    MAX_HASHABLE_LENGTH.
+ */
+KmerCounter CountKmers(const std::string_view text, const int k, const int threads, bool canonical)
+{
+    if (k <= 0 || k > MAX_HASHABLE_LENGTH)
+        throw std::runtime_error(
+            "The length of k-mer must be in [1, MAX_HASHABLE_LENGTH].");
+
+    if (!isPatternValid(text.length(), k))
+        return KmerCounter(k);
+
+    auto shards = SplitShards(text, ThreadCount(threads), k - 1);
+    std::vector<KmerCounter> partial;
+    partial.reserve(shards.size());
+    for (const auto &shard : shards)
+        partial.emplace_back(k, SubstrCount(shard.length(), k));
+
+    ParallelFor(shards.size(), threads, [&](const size_t i) {
+        ForEachKmer(shards[i], k, [&](const size_t, const RollingKmer &kmer) {
+            if (canonical)
+                partial[i].add(kmer.canonical(), kmer.canonicalWeight());
+            else
+                partial[i].increment(kmer.forward());
+        });
+    });
+
+    for (size_t i = 1; i < partial.size(); i++)
+        partial[0].merge(partial[i]);
+
+    return std::move(partial[0]);
+}
+
 /*!
     Generate the frequency array of a DNA string.
 
@@ -587,28 +1463,116 @@ unordered_map<string, uint> FrequencyTableWithMismatches(
     an array of length 4^k, where the i-th element of the array holds the
     number of times that the i-th k-mer (in the lexicographic order) appears in
     \a text . Therefore, the index of frequency array is hash value of a k-mer.
+
+    k-mers are encoded by a RollingKmer in O(1) each, and those containing a
+    non-ACGT byte are not counted.
  */
 std::vector<uint> FrequencyArray(const std::string_view text, const int k)
 {
     size_t t_len = text.length();
-    size_t n_kmer = SubstrCount(t_len, k);
 
     if (!isPatternValid(t_len, k))
         return std::vector<uint>();
 
+    if (k > MAX_HASHABLE_LENGTH)
+        throw std::runtime_error(
+            "The length of the pattern exceeds the maximum hashable length.");
+
     // Create a vector of size 4^k with all values as zero.
-    std::vector<uint> freq_array(pow(4, k), 0);
- 
-    for (int i = 0; i < n_kmer; i++) {
+    std::vector<uint> freq_array(hash_t(1) << 2*k, 0);
+
+    ForEachKmer(text, k, [&](const size_t, const RollingKmer &kmer) {
         // Unlike std::map::operator[], this operator never inserts a new
         // element into the container. Accessing a nonexistent element
         // through this operator is undefined behavior.
-        freq_array[PatternToNumber(text.substr(i, k))]++;
-    }
+        freq_array[kmer.forward()]++;
+    });
 
     return freq_array;    
 }
 
+/*!
+    Generate the frequency array with several \a threads.
+
+    \a text is split into shards overlapping by k - 1 bases, so that each
+    k-mer is counted by exactly one thread. Each thread fills a frequency
+    array of its own, so memory is 4^k per thread, and the arrays are then
+    summed slice by slice in parallel. Shards are at least 1 MiB and 4^k
+    bases long, and the threads are capped to keep all the arrays within
+    1 GiB, so short texts and large k are counted on one thread. The
+    result is identical to the serial FrequencyArray().
+ */
+std::vector<uint> FrequencyArray(const std::string_view text, const int k, const int threads)
+{
+    return FrequencyArray(text, k, threads, false);
+}
+
+/*!
+    Count the k-mers of \a text into a frequency array, each under its
+    canonical code if \a canonical is set.
+ */
+static std::vector<uint> FrequencyArrayOfShard(const std::string_view text, const int k, bool canonical)
+{
+    if (!canonical)
+        return FrequencyArray(text, k);
+
+    if (!isPatternValid(text.length(), k))
+        return std::vector<uint>();
+
+    if (k > MAX_HASHABLE_LENGTH)
+        throw std::runtime_error(
+            "The length of the pattern exceeds the maximum hashable length.");
+
+    std::vector<uint> freq_array(hash_t(1) << 2*k, 0);
+    ForEachKmer(text, k, [&](const size_t, const RollingKmer &kmer) {
+        freq_array[kmer.canonical()] += kmer.canonicalWeight();
+    });
+
+    return freq_array;
+}
+
+/*!
+    With \a canonical, a k-mer and its reverse complement are counted
+    together under the canonical code, the smaller of their two codes, and
+    the entries of non-canonical codes stay zero. The reverse complement
+    code is rolled along with the forward one, so this costs no more than
+    counting a single strand.
+ */
+std::vector<uint> FrequencyArray(const std::string_view text, const int k, const int threads, bool canonical)
+{
+    // Each shard fills an array of 4^k counters, so a shard should hold
+    // more k-mers than the array has counters, and the arrays of all the
+    // shards together are kept within 2^MAX_ARRAYS_BITS bytes (1 GiB).
+    const int MAX_ARRAYS_BITS = 30;
+    const int array_bits = 2*k + 2;
+    if (!isPatternValid(text.length(), k) || array_bits + 1 > MAX_ARRAYS_BITS)
+        return FrequencyArrayOfShard(text, k, canonical);
+
+    const size_t MIN_SHARD_LENGTH = std::max<size_t>(1 << 20, size_t(1) << 2*k);
+    size_t n_threads = std::min<size_t>(ThreadCount(threads), text.length() / MIN_SHARD_LENGTH);
+    n_threads = std::min(n_threads, size_t(1) << (MAX_ARRAYS_BITS - array_bits));
+    if (n_threads <= 1)
+        return FrequencyArrayOfShard(text, k, canonical);
+
+    auto shards = SplitShards(text, n_threads, k - 1);
+    std::vector<std::vector<uint>> partial(shards.size());
+    ParallelFor(shards.size(), n_threads, [&](const size_t i) {
+        partial[i] = FrequencyArrayOfShard(shards[i], k, canonical);
+    });
+
+    auto &freq_array = partial[0];
+    size_t slice = (freq_array.size() + n_threads - 1) / n_threads;
+    ParallelFor(n_threads, n_threads, [&](const size_t t) {
+        size_t end = std::min(freq_array.size(), (t + 1) * slice);
+        for (size_t p = 1; p < partial.size(); p++) {
+            for (size_t i = t * slice; i < end; i++)
+                freq_array[i] += partial[p][i];
+        }
+    });
+
+    return std::move(freq_array);
+}
+
 inline bool
 is_ntp(char c)
 {
@@ -653,7 +1617,7 @@ hash_t PatternToNumberBitwise(const std::string_view pattern)
     auto p = pattern.begin();
 
     while (len-- > 0) {
-        int val = BASE_TO_INT[*p++];
+        hash_t val = BASE_TO_INT[static_cast<unsigned char>(*p++)];
         hash |= val << 2*len;
     }
 
@@ -675,13 +1639,9 @@ std::string NumberToPatternBitwise(const hash_t number, const int length)
 {
     std::string pattern;
 
-    for (int len = length; len > 0; len--) {
-        hash_t mask = 0;
-        mask = ~((~mask) << (2*len));
-        pattern.push_back(
-            INT_TO_BASE[(number & mask) >> 2*(len - 1)]
-        );
-    }
+    pattern.reserve(length);
+    for (int len = length; len > 0; len--)
+        pattern.push_back(INT_TO_BASE[(number >> 2*(len - 1)) & 3]);
 
     return pattern;
 }
@@ -691,19 +1651,19 @@ std::set<std::string> FindClumpsRaw(const std::string_view genome, int k, int wi
     std::set<std::string> clumps;
 
     // Create a vector of size 4^k with all values as zero.
-    std::vector<size_t> freq_array(pow(4, k), 0);
+    std::vector<size_t> freq_array(hash_t(1) << 2*k, 0);
  
     // This is used to mark which pattern formed a clump. The pos of this
     // vector is hash value of a k-mer.
-    std::vector<bool> is_clump(pow(4, k), false);
+    std::vector<bool> is_clump(freq_array.size(), false);
     for (size_t i = 0; i < SubstrCount(genome.length(), window_length); i++) {
         // Re-initialise to zero.
         std::fill(freq_array.begin(), freq_array.end(), 0);
 
         auto genome_window = genome.substr(i, window_length);
-        for (int i = 0; i < SubstrCount(genome_window.length(), k); i++) {
-            freq_array[PatternToNumber(genome_window.substr(i, k))]++;
-        }
+        ForEachKmer(genome_window, k, [&](const size_t, const RollingKmer &kmer) {
+            freq_array[kmer.forward()]++;
+        });
 
         for (size_t i = 0; i < freq_array.size(); i++) {
             if (freq_array[i] >= times)
@@ -743,34 +1703,38 @@ std::set<std::string> FindClumpsRaw2(const std::string_view genome, int k, int w
 /*!
     The max \a k is 32, which can be hashed in to \c hash_t type. The
     argument \a k is also limited by the available memory.
+
+    Two RollingKmer run along the genome: the head one encodes the k-mer
+    entering the window and the tail one, lagging a window behind, encodes
+    the k-mer leaving it. So each slide costs O(1) whatever \a k is.
  */
 std::set<std::string> FindClumpsBetterWithPerfectHash(const std::string_view genome, int k, int window_length, int times)
 {
     std::set<std::string> clumps;
+    if (!isPatternValid(genome.length(), window_length) || !isPatternValid(window_length, k))
+        return clumps;
+
+    std::vector<uint> freq_array(hash_t(1) << 2*k, 0);
     // This is used to mark which pattern formed a clump. The pos of this
     // vector is hash value of a k-mer.
-    std::vector<bool> is_clump(pow(4, k), false);
+    std::vector<bool> is_clump(freq_array.size(), false);
 
-    // Handle First window
-    auto freq_array = FrequencyArray(genome.substr(0, window_length), k);
-    for (size_t i = 0; i < freq_array.size(); i++) {
-        if (freq_array[i] >= times)
-            is_clump[i] = true;
-    }
-
-    // Update following window
-    for (size_t i = 1; i < SubstrCount(genome.length(), window_length); i++) {
-        // Prior k-mer have been passed so we reduce it's frequency. Because
-        // it's frequency is lower than last window, there is no need to check
-        // it's number of occurrence.
-        auto prior_kmer_hash = PatternToNumber(genome.substr(i-1, k));
-        --freq_array[prior_kmer_hash];
+    // Number of k-mers in a window.
+    size_t span = SubstrCount(window_length, k);
+    RollingKmer head(k), tail(k);
+    for (size_t i = 0; i < genome.length(); i++) {
+        if (i >= span && tail.push(genome[i - span]) && tail.ready()) {
+            // Prior k-mer have been passed so we reduce it's frequency.
+            // Because it's frequency is lower than last window, there is no
+            // need to check it's number of occurrence.
+            --freq_array[tail.forward()];
+        }
 
         // Next k-mer is new so we increase it's frequncy, and check for it's
         // number of occurrence.
-        auto next_kmer_hash = PatternToNumber(genome.substr(i + (window_length - k), k));
-        if (++freq_array[next_kmer_hash] >= times && !is_clump[next_kmer_hash])
-            is_clump[next_kmer_hash] = true;
+        if (head.push(genome[i]) && head.ready()
+                && ++freq_array[head.forward()] >= static_cast<uint>(times))
+            is_clump[head.forward()] = true;
     }
 
     for (size_t i = 0; i < is_clump.size(); i++) {
@@ -781,12 +1745,87 @@ std::set<std::string> FindClumpsBetterWithPerfectHash(const std::string_view gen
     return clumps;
 }
 
+/*!
+    Find clumps with a KmerCounter, so the count table is a dense array for
+    small \a k and a hash table sized to the distinct k-mers of \a genome
+    for large \a k, instead of 4^k counters. k-mers are encoded by a head
+    and a tail RollingKmer as in FindClumpsBetterWithPerfectHash().
+
+    A k-mer is recorded when its count reaches \a times, which it must do
+    on an increment in any window where it forms a clump.
+ */
+std::set<std::string> FindClumpsWithKmerCounter(const std::string_view genome, int k, int window_length, int times)
+{
+    std::set<std::string> clumps;
+    if (!isPatternValid(genome.length(), window_length) || !isPatternValid(window_length, k))
+        return clumps;
+
+    KmerCounter counter(k, SubstrCount(genome.length(), k));
+    std::vector<hash_t> clump_codes;
+
+    size_t span = SubstrCount(window_length, k);
+    RollingKmer head(k), tail(k);
+    for (size_t i = 0; i < genome.length(); i++) {
+        if (i >= span && tail.push(genome[i - span]) && tail.ready())
+            counter.decrement(tail.forward());
+
+        if (head.push(genome[i]) && head.ready()
+                && counter.increment(head.forward()) == static_cast<uint>(times))
+            clump_codes.push_back(head.forward());
+    }
+
+    for (auto code : clump_codes)
+        clumps.insert(NumberToPatternBitwise(code, k));
+
+    return clumps;
+}
+
+/*!
+    Slide the window over \a genome with a FlatCounter of packed k-mer codes,
+    encoded by a head and a tail \a Rolling encoder, and spell out the code
+    of each k-mer whose count reaches \a times.
+ */
+template <typename Rolling>
+static std::set<std::string> FindClumpsPacked(const std::string_view genome, int k, int window_length, int times)
+{
+    typedef decltype(Rolling(k).forward()) code_type;
+    std::vector<code_type> found;
+    FlatCounter<code_type> counter;
+
+    size_t span = SubstrCount(window_length, k);
+    Rolling head(k), tail(k);
+    for (size_t i = 0; i < genome.length(); i++) {
+        if (i >= span && tail.push(genome[i - span]) && tail.ready())
+            --counter[tail.forward()];
+
+        if (head.push(genome[i]) && head.ready()
+                && ++counter[head.forward()] == static_cast<uint>(times))
+            found.push_back(head.forward());
+    }
+
+    std::set<std::string> clumps;
+    for (const auto &code : found)
+        clumps.insert(SpellKmer(code, k));
+    return clumps;
+}
+
 /*!
     By benchmark testing, this function is not as efficient on large data sets
     as FindClumpsBetterWithPerfectHash
+
+    k-mers up to KmerTable128::MAX_K bases are counted by their packed code
+    in a FlatCounter, longer ones by string.
  */
 std::set<std::string> FindClumpsBetterWithStdHash(const std::string_view genome, int k, int window_length, int times)
 {
+    if (!isPatternValid(genome.length(), window_length) || !isPatternValid(window_length, k))
+        return std::set<std::string>();
+
+    if (k <= RollingKmer::MAX_K)
+        return FindClumpsPacked<RollingKmer>(genome, k, window_length, times);
+    else if (k <= RollingKmer128::MAX_K)
+        return FindClumpsPacked<RollingKmer128>(genome, k, window_length, times);
+
     std::set<std::string> clumps;
     std::unordered_map<std::string, bool> is_clump;
 
@@ -843,7 +1882,7 @@ std::set<std::string> FindClumps(const std::string_view genome, int k, int windo
         if (k > MAX_HASHABLE_LENGTH)
             return FindClumpsBetterWithStdHash(genome, k, window_length, times);
         else
-            return FindClumpsBetterWithPerfectHash(genome, k, window_length, times);
+            return FindClumpsWithKmerCounter(genome, k, window_length, times);
     }
     }
 }
@@ -855,35 +1894,58 @@ std::set<std::string> FindClumps(const std::string_view genome, int k, int windo
     total number of occurrences of 'G' and 'C' in \a genome. The skew should
     achieve a minimum at the position where the reverse half-strand ends and
     the forward half-strand begins.
+
+    The skew is computed in one pass by a SkewScanner, without being stored.
  */
 std::vector<size_t> FindMinimumSkew(const std::string_view genome)
 {
-    int accumulator = 0, min = 0;
-    std::vector<int> skew(genome.length() + 1, 0);
-    for (size_t i = 0; i < genome.length(); i++) {
-        switch (genome[i])
-        {
-        case 'g':
-        case 'G':
-            skew[i+1] = ++accumulator;
-            break;
-        case 'c':
-        case 'C':
-            skew[i+1] = --accumulator;
-            break;
-        default:
-            skew[i+1] = accumulator;
-            break;
-        }
+    SkewScanner scanner;
+    scanner.feed(genome);
+    return scanner.minima();
+}
 
-        if (accumulator < min) {
-            min = accumulator;
-        }
+/*!
+    With several \a threads, chunks of \a genome are scanned concurrently,
+    each from a skew of zero, for its G - C delta and its local minima. A
+    prefix sum of the deltas gives the skew at the start of every chunk,
+    which turns local minima into global ones. The result is the same as
+    with one thread.
+ */
+std::vector<size_t> FindMinimumSkew(const std::string_view genome, const int threads)
+{
+    const size_t MIN_CHUNK_LENGTH = 1 << 20;
+
+    size_t n = 4 * ThreadCount(threads);
+    n = std::min(n, genome.length() / MIN_CHUNK_LENGTH);
+    if (ThreadCount(threads) <= 1 || n <= 1)
+        return FindMinimumSkew(genome);
+
+    auto chunks = SplitShards(genome, n, 0);
+    std::vector<SkewScanner> scanners(chunks.size());
+    ParallelFor(chunks.size(), threads, [&](const size_t i) {
+        scanners[i].feed(chunks[i]);
+    });
+
+    // Skew at the start of each chunk, and the global minimum.
+    std::vector<int64_t> offsets(chunks.size(), 0);
+    int64_t minimum = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (i > 0)
+            offsets[i] = offsets[i - 1] + scanners[i - 1].skew();
+        minimum = std::min(minimum, offsets[i] + scanners[i].minimum());
     }
 
     std::vector<size_t> locations;
-    for (size_t i = 0; i < skew.size(); i++) {
-        if (skew[i] == min) locations.push_back(i);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (offsets[i] + scanners[i].minimum() != minimum)
+            continue;
+
+        size_t start = chunks[i].data() - genome.data();
+        for (auto position : scanners[i].minima()) {
+            // The start of a chunk is the end of the previous one.
+            if (i == 0 || position != 0)
+                locations.push_back(start + position);
+        }
     }
 
     return locations;
@@ -899,22 +1961,46 @@ std::vector<size_t> FindMinimumSkew(const std::string_view genome)
  */
 size_t HammingDistance(const std::string_view pattern1, const std::string_view pattern2) noexcept(false)
 {
-    size_t d = 0;
-
     if (pattern1.length() != pattern2.length())
         throw std::runtime_error(
             "Can not compute Hamming distance between "
             "sequences of unequal length.");
 
-    for (size_t i = 0; i < pattern1.length(); i++) {
-        if (pattern1[i] != pattern2[i])
-            d++;
-    }
-
-    return d;
+    return CountMismatches(pattern1.data(), pattern2.data(), pattern1.length());
 }
 
 const static char NUCLEOTIDES[4] = {'A', 'C', 'G', 'T'};
+
+/*!
+    Whether \a pattern is made of upper case ACGT only, and fits a hash_t.
+ */
+static bool isPackable(const std::string_view pattern) noexcept
+{
+    return !pattern.empty() && pattern.length() <= static_cast<size_t>(MAX_HASHABLE_LENGTH)
+        && std::all_of(pattern.begin(), pattern.end(),
+                       [](const char c) { return StrictBaseCode(c) >= 0; });
+}
+
+/*!
+    Generate the d-neighborhood of a packable \a pattern as codes with
+    ForEachNeighbor(), and spell out the k-mers only at the end. Codes sort
+    in the lexicographic order of their k-mers, so the set is filled in
+    order.
+ */
+static std::set<std::string> PackedNeighbors(const std::string_view pattern, int d)
+{
+    int k = pattern.length();
+    std::vector<hash_t> codes;
+    codes.reserve(NeighborCount(k, d));
+    Neighbors(PatternToNumberBitwise(pattern), k, d, codes);
+    std::sort(codes.begin(), codes.end());
+
+    std::set<std::string> neighborhood;
+    for (auto code : codes)
+        neighborhood.emplace_hint(neighborhood.end(), NumberToPatternBitwise(code, k));
+
+    return neighborhood;
+}
 /*!
     \brief Generate the d-Neighborhood of a String
 
@@ -923,6 +2009,9 @@ const static char NUCLEOTIDES[4] = {'A', 'C', 'G', 'T'};
  */
 std::set<std::string> NeighborsRecursive(const std::string_view pattern, int d)
 {
+    if (isPackable(pattern))
+        return PackedNeighbors(pattern, d);
+
     if (d == 0)
         return {std::string(pattern)};
 
@@ -954,6 +2043,9 @@ std::set<std::string> NeighborsRecursive(const std::string_view pattern, int d)
  */
 set<string> ImmediateNeighbors(const string_view pattern)
 {
+    if (isPackable(pattern))
+        return PackedNeighbors(pattern, 1);
+
     set<string> neighborhood{string(pattern)};
 
     for (int i = 0; i < pattern.length(); i++) {
@@ -975,6 +2067,9 @@ set<string> ImmediateNeighbors(const string_view pattern)
  */
 set<string> NeighborsIterative(const string_view pattern, int d)
 {
+    if (isPackable(pattern))
+        return PackedNeighbors(pattern, d);
+
     set<string> neighborhood{string(pattern)};
 
     for (int i = 1; i <= d; i++) {
@@ -989,31 +2084,138 @@ set<string> NeighborsIterative(const string_view pattern, int d)
     return neighborhood;
 }
 
-static const map<char, char> base_comp = {
-    {'A', 'T'}, {'T', 'A'},
-    {'C', 'G'}, {'G', 'C'}
-};
+/*!
+    Count occurrences of \a pattern in a 2-bit packed \a text, under the
+    rules of PatternIndex(const PackedSequence &, std::string_view).
+ */
+size_t PatternCount(const PackedSequence &text, const std::string_view pattern)
+{
+    return PatternIndex(text, pattern).size();
+}
+
+/*!
+    Find all starting positions of \a pattern in a 2-bit packed \a text by
+    comparing rolling k-mer codes with the code of \a pattern.
+
+    Packing drops the case of \a text, so bases are compared
+    case-insensitively, unlike PatternIndex(std::string_view,
+    std::string_view). k-mers of \a text overlapping an ambiguous base
+    never match, and neither does a \a pattern holding a non-ACGT byte.
+    The length of \a pattern is limited to MAX_HASHABLE_LENGTH.
+ */
+std::vector<size_t> PatternIndex(const PackedSequence &text, const std::string_view pattern)
+{
+    std::vector<size_t> output;
+    if (!isPatternValid(text.size(), pattern.length())
+            || pattern.length() > static_cast<size_t>(RollingKmer::MAX_K))
+        return output;
+
+    RollingKmer target(pattern.length());
+    for (char base : pattern) {
+        if (!target.push(base))
+            return output;
+    }
 
-string
-ReverseComplement(const string_view oriSeq) noexcept(false)
+    for (const auto &kmer : text.kmers(pattern.length())) {
+        if (kmer.forward == target.forward())
+            output.push_back(kmer.position);
+    }
+
+    return output;
+}
+
+/*!
+    Generate the frequency array of a 2-bit packed \a text. k-mers
+    overlapping an ambiguous base are not counted.
+ */
+std::vector<uint> FrequencyArray(const PackedSequence &text, const int k)
 {
-    size_t len = oriSeq.length();
-    string revSeq;
-    revSeq.reserve(len);
+    if (!isPatternValid(text.size(), k))
+        return std::vector<uint>();
 
-    // Get complementary
-    for (const char &nucleotide : oriSeq) {
-        try {
-            revSeq.push_back(base_comp.at(nucleotide));
-        } catch(std::out_of_range &) {
-            throw UnknownNucleotideError(nucleotide);
+    std::vector<uint> freq_array(hash_t(1) << 2*k, 0);
+    for (const auto &kmer : text.kmers(k))
+        freq_array[kmer.forward]++;
+
+    return freq_array;
+}
+
+/*!
+    Find the most frequent k-mers of a 2-bit packed \a text by sorting the
+    k-mer codes, which works for any \a k up to MAX_HASHABLE_LENGTH.
+ */
+std::set<std::string> FrequentWords(const PackedSequence &text, const int k)
+{
+    if (!isPatternValid(text.size(), k))
+        return std::set<std::string>();
+
+    std::vector<hash_t> index;
+    index.reserve(SubstrCount(text.size(), k));
+    for (const auto &kmer : text.kmers(k))
+        index.push_back(kmer.forward);
+
+    RadixSort(index, 2*k);
+
+    // Frequent k-mers are the longest runs of identical codes.
+    size_t max = 0;
+    std::vector<hash_t> max_codes;
+    for (size_t i = 0, j; i < index.size(); i = j) {
+        for (j = i + 1; j < index.size() && index[j] == index[i]; j++)
+            ;
+        if (j - i > max) {
+            max = j - i;
+            max_codes.clear();
         }
+        if (j - i == max)
+            max_codes.push_back(index[i]);
     }
 
-    // Get reversed
-    std::reverse(revSeq.begin(), revSeq.end());
+    std::set<std::string> max_freq;
+    for (auto code : max_codes)
+        max_freq.insert(NumberToPatternBitwise(code, k));
+
+    return max_freq;
+}
 
-    return revSeq;
+/*!
+    Find patterns forming clumps in a 2-bit packed \a genome. Each window
+    slide extracts the leaving and the entering k-mer codes in O(1) with
+    PackedSequence::kmer(). The argument \a k is limited by the available
+    memory like FindClumpsBetterWithPerfectHash().
+ */
+std::set<std::string> FindClumps(const PackedSequence &genome, int k, int window_length, int times)
+{
+    std::set<std::string> clumps;
+    if (!isPatternValid(genome.size(), window_length) || !isPatternValid(window_length, k))
+        return clumps;
+
+    std::vector<uint> freq_array(hash_t(1) << 2*k, 0);
+    std::vector<bool> is_clump(freq_array.size(), false);
+
+    // Number of k-mers in a window and of windows in the genome.
+    const size_t span = SubstrCount(window_length, k);
+    const size_t n_window = SubstrCount(genome.size(), window_length);
+    const uint threshold = static_cast<uint>(times);
+
+    hash_t code;
+    for (size_t i = 0; i < span; i++) {
+        if (genome.kmer(i, k, code) && ++freq_array[code] >= threshold)
+            is_clump[code] = true;
+    }
+
+    for (size_t i = 1; i < n_window; i++) {
+        if (genome.kmer(i - 1, k, code))
+            --freq_array[code];
+        if (genome.kmer(i + span - 1, k, code) && ++freq_array[code] >= threshold)
+            is_clump[code] = true;
+    }
+
+    for (size_t i = 0; i < is_clump.size(); i++) {
+        if (is_clump[i])
+            clumps.insert(NumberToPatternBitwise(i, k));
+    }
+
+    return clumps;
 }
 
 BIOUTILS_END_SUB_NAMESPACE(algorithms)
\ No newline at end of file
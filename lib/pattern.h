@@ -6,16 +6,20 @@
 #include <string_view>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "global.h"
+#include "kmer.h"
+#include "counter.h"
+#include "packedseq.h"
+#include "revcomp.h"
 
 BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
 
 #define ISNTP(C) ((C) == 'A' || (C) == 'T' || (C) == 'C' || (C) == 'G' \
         || (C) == 'a' || (C) == 't' || (C) == 'c' || (C) == 'g')
 
-typedef unsigned long long hash_t;
 extern const int MAX_HASHABLE_LENGTH;
 
 enum class PatternCountAlgorithms { BruteForce, BruteForceByHand, RabinKarp };
@@ -26,34 +30,63 @@ hash_t PatternToNumberBitwise(const std::string_view pattern);
 hash_t PatternToNumberRecursive(const std::string_view pattern);
 std::string NumberToPatternBitwise(const hash_t number, const int length);
 bool is_ntp(char c);
-std::string ReverseComplement(const std::string_view oriSeq);
 
 void find_do(const std::string_view text, const std::string_view pattern,
     std::function<void(const size_t, const std::string_view, const std::string_view)> callback);
 size_t PatternCount(const std::string_view text, const std::string_view pattern, AlgorithmEfficiency algo);
+size_t PatternCount(const std::string_view text, const std::string_view pattern, AlgorithmEfficiency algo, const int threads);
 size_t PatternCount_RK(const std::string_view text, const std::string_view pattern);
 size_t PatternCount_BF(const std::string_view text, const std::string_view pattern);
+size_t PatternCountByMatcher(const std::string_view text, const std::string_view pattern);
 std::vector<size_t> PatternIndex(const std::string_view text, const std::string_view pattern);
+std::vector<size_t> PatternIndex(const std::string_view text, const std::string_view pattern, const int threads);
+std::vector<size_t> PatternIndex_RK(const std::string_view text, const std::string_view pattern);
 std::vector<size_t> PatternIndexApproximate(const std::string_view text, const std::string_view pattern, const size_t d);
+std::vector<size_t> PatternIndexApproximateShiftAnd(const std::string_view text, const std::string_view pattern, size_t d);
+std::vector<size_t> PatternIndexEditDistance(const std::string_view text, const std::string_view pattern, const size_t d);
 
-std::set<std::string> FrequentWords(const std::string_view text, const int k, AlgorithmEfficiency algo = AlgorithmEfficiency::Slow);
+std::set<std::string> FrequentWords(const std::string_view text, const int k,
+    AlgorithmEfficiency algo = AlgorithmEfficiency::Slow, const int threads = 1);
 std::set<std::string> FrequentWordsSlow(const std::string_view text, const int k);
 std::set<std::string> FrequentWordsByPerfectHash(const std::string_view text, const int k);
+std::set<std::string> FrequentWordsByPerfectHash(const std::string_view text, const int k, const int threads);
 std::set<std::string> FrequentWordsByStdHash(const std::string_view text, const int k);
+std::set<std::string> FrequentWordsByStdHash(const std::string_view text, const int k, const int threads);
 std::set<std::string> FrequentWordsBySorting(const std::string_view text, const int k);
+std::set<std::string> FrequentWordsBySorting(const std::string_view text, const int k, const int threads);
+std::set<std::string> FrequentWordsByKmerCounter(const std::string_view text, const int k, const int threads = 1);
+std::vector<std::pair<std::string, uint>> TopFrequentWords(
+    const std::string_view text, const int k, const size_t n, const int threads = 1);
+std::vector<std::pair<std::string, uint>> FrequentWordsAtLeast(
+    const std::string_view text, const int k, const uint min_count, const int threads = 1);
+KmerCounter CountKmers(const std::string_view text, const int k, const int threads = 1, bool canonical = false);
 std::unordered_map<std::string, uint> FrequencyTable(const std::string_view text, const int k);
+std::unordered_map<std::string, uint> FrequencyTable(const std::string_view text, const int k, const int threads);
+std::unordered_map<std::string, uint> FrequencyTable(const std::string_view text, const int k, const int threads, bool canonical);
 std::unordered_map<std::string, uint> FrequencyTableWithMismatches(
-    const std::string_view text, const int k, const int d, bool rev_comp = false);
+    const std::string_view text, const int k, const int d, bool rev_comp = false, bool canonical = false);
 std::vector<uint> FrequencyArray(const std::string_view text, const int k);
+std::vector<uint> FrequencyArray(const std::string_view text, const int k, const int threads);
+std::vector<uint> FrequencyArray(const std::string_view text, const int k, const int threads, bool canonical);
 std::set<std::string> FrequentWordsWithMismatches(
     const std::string_view text, const int k, const int d, bool rev_comp = false);
 std::set<std::string> FrequentWordsWithMismatchesBySorting(
     const std::string_view text, const int k, const int d, bool rev_comp = false);
+std::set<std::string> FrequentWordsWithMismatchesByKmerCounter(
+    const std::string_view text, const int k, const int d, bool rev_comp = false, const int threads = 1);
 
 std::set<std::string> FindClumps(const std::string_view genome, int k, int window_length, int times, AlgorithmEfficiency algo = AlgorithmEfficiency::Default);
 std::set<std::string> FindClumpsBetterWithStdHash(const std::string_view genome, int k, int window_length, int times);
 std::set<std::string> FindClumpsBetterWithPerfectHash(const std::string_view genome, int k, int window_length, int times);
+std::set<std::string> FindClumpsWithKmerCounter(const std::string_view genome, int k, int window_length, int times);
 std::vector<size_t> FindMinimumSkew(const std::string_view genome);
+std::vector<size_t> FindMinimumSkew(const std::string_view genome, const int threads);
+
+size_t PatternCount(const PackedSequence &text, const std::string_view pattern);
+std::vector<size_t> PatternIndex(const PackedSequence &text, const std::string_view pattern);
+std::vector<uint> FrequencyArray(const PackedSequence &text, const int k);
+std::set<std::string> FrequentWords(const PackedSequence &text, const int k);
+std::set<std::string> FindClumps(const PackedSequence &genome, int k, int window_length, int times);
 
 size_t HammingDistance(const std::string_view pattern1, const std::string_view pattern2);
 std::set<std::string> NeighborsRecursive(const std::string_view pattern, int d);
@@ -0,0 +1,265 @@
+#include "revcomp.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "exceptions.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BIOUTILS_HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+// Bytes swapped at a time by ReverseComplementInPlace().
+static const size_t SWAP_LENGTH = 4096;
+
+static constexpr std::array<char, 256> MakeComplementTable()
+{
+    std::array<char, 256> table{};
+    const char pairs[][2] = {
+        {'A', 'T'}, {'C', 'G'}, {'R', 'Y'}, {'K', 'M'}, {'B', 'V'}, {'D', 'H'},
+        {'S', 'S'}, {'W', 'W'}, {'N', 'N'}
+    };
+    for (const auto &pair : pairs) {
+        table[pair[0]] = pair[1];
+        table[pair[1]] = pair[0];
+        table[pair[0] | 0x20] = pair[1] | 0x20;
+        table[pair[1] | 0x20] = pair[0] | 0x20;
+    }
+    table['U'] = 'A';
+    table['u'] = 'a';
+    table['-'] = '-';
+    table['.'] = '.';
+    return table;
+}
+
+// Complement of every byte, 0 for a byte which is not a nucleotide.
+static constexpr std::array<char, 256> COMPLEMENT = MakeComplementTable();
+
+char Complement(const char base)
+{
+    char complement = COMPLEMENT[static_cast<unsigned char>(base)];
+    if (complement == 0)
+        throw utils::UnknownNucleotideError(base);
+    return complement;
+}
+
+/*!
+    A kernel writes the reverse complement of the \a n bytes at \a in to
+    \a out, which must not overlap them.
+ */
+typedef void (*ReverseComplementFuncPtr)(const char *, const size_t, char *);
+
+static void ReverseComplementScalar(const char *in, const size_t n, char *out)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = Complement(in[n - 1 - i]);
+}
+
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+
+/*!
+    Letters only differ from their complement in the 5 low bits, the 3 high
+    bits holding the case. The complement of the 5 low bits of a letter is
+    looked up by a 16-byte shuffle on the 4 lowest, in the table for @ to O
+    or for P to _ depending on the 5th. 0 means the letter is not a
+    nucleotide, and so does any byte outside 0x40 to 0x7F. A block holding
+    one, or a gap, is left to the scalar kernel.
+ */
+static constexpr std::array<char, 32> MakeLetterTable()
+{
+    std::array<char, 32> table{};
+    for (int i = 0; i < 32; i++)
+        table[i] = COMPLEMENT[0x40 + i] & 0x1F;
+    return table;
+}
+
+alignas(16) static constexpr std::array<char, 32> LETTER_COMPLEMENT = MakeLetterTable();
+
+__attribute__((target("ssse3")))
+static void ReverseComplementSSSE3(const char *in, const size_t n, char *out)
+{
+    const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i low = _mm_load_si128(reinterpret_cast<const __m128i *>(LETTER_COMPLEMENT.data()));
+    const __m128i high = _mm_load_si128(reinterpret_cast<const __m128i *>(LETTER_COMPLEMENT.data() + 16));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i bit4 = _mm_set1_epi8(0x10);
+    const __m128i top = _mm_set1_epi8(static_cast<char>(0xC0));
+    const __m128i letter = _mm_set1_epi8(0x40);
+    const __m128i low5 = _mm_set1_epi8(0x1F);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const char *block = in + n - i - 16;
+        __m128i x = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block)), reverse);
+
+        // No blend before SSE4.1.
+        __m128i index = _mm_and_si128(x, nibble);
+        __m128i upper = _mm_cmpeq_epi8(_mm_and_si128(x, bit4), bit4);
+        __m128i complement = _mm_or_si128(
+            _mm_and_si128(upper, _mm_shuffle_epi8(high, index)),
+            _mm_andnot_si128(upper, _mm_shuffle_epi8(low, index)));
+
+        __m128i good = _mm_andnot_si128(
+            _mm_cmpeq_epi8(complement, _mm_setzero_si128()),
+            _mm_cmpeq_epi8(_mm_and_si128(x, top), letter));
+        if (_mm_movemask_epi8(good) != 0xFFFF) {
+            ReverseComplementScalar(block, 16, out + i);
+            continue;
+        }
+
+        __m128i y = _mm_or_si128(_mm_andnot_si128(low5, x), complement);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), y);
+    }
+
+    ReverseComplementScalar(in, n - i, out + i);
+}
+
+__attribute__((target("avx2")))
+static void ReverseComplementAVX2(const char *in, const size_t n, char *out)
+{
+    const __m256i reverse = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256i low = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i *>(LETTER_COMPLEMENT.data())));
+    const __m256i high = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i *>(LETTER_COMPLEMENT.data() + 16)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i bit4 = _mm256_set1_epi8(0x10);
+    const __m256i top = _mm256_set1_epi8(static_cast<char>(0xC0));
+    const __m256i letter = _mm256_set1_epi8(0x40);
+    const __m256i low5 = _mm256_set1_epi8(0x1F);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const char *block = in + n - i - 32;
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+        // Reverse the bytes of each lane, then swap the lanes.
+        x = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, reverse), 0x4E);
+
+        __m256i index = _mm256_and_si256(x, nibble);
+        __m256i upper = _mm256_cmpeq_epi8(_mm256_and_si256(x, bit4), bit4);
+        __m256i complement = _mm256_blendv_epi8(
+            _mm256_shuffle_epi8(low, index), _mm256_shuffle_epi8(high, index), upper);
+
+        __m256i good = _mm256_andnot_si256(
+            _mm256_cmpeq_epi8(complement, _mm256_setzero_si256()),
+            _mm256_cmpeq_epi8(_mm256_and_si256(x, top), letter));
+        if (_mm256_movemask_epi8(good) != -1) {
+            ReverseComplementScalar(block, 32, out + i);
+            continue;
+        }
+
+        __m256i y = _mm256_or_si256(_mm256_andnot_si256(low5, x), complement);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), y);
+    }
+
+    ReverseComplementScalar(in, n - i, out + i);
+}
+
+#endif // BIOUTILS_HAVE_X86_KERNELS
+
+struct Kernel {
+    ReverseComplementFuncPtr fun;
+    const char *name;
+};
+
+static Kernel SelectKernel() noexcept
+{
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {ReverseComplementAVX2, "avx2"};
+    if (__builtin_cpu_supports("ssse3"))
+        return {ReverseComplementSSSE3, "ssse3"};
+#endif
+    return {ReverseComplementScalar, "scalar"};
+}
+
+static const Kernel &ActiveKernel() noexcept
+{
+    static const Kernel kernel = SelectKernel();
+    return kernel;
+}
+
+const char *ReverseComplementKernel() noexcept
+{
+    return ActiveKernel().name;
+}
+
+/*!
+    \brief Reverse complement of a nucleotide sequence.
+
+    Bases are complemented by Complement(), 32 or 16 at a time with AVX2
+    or SSSE3 shuffles, picked at run time from what the CPU supports, and
+    by a lookup table otherwise.
+ */
+std::string ReverseComplement(const std::string_view seq)
+{
+    std::string output(seq.length(), '\0');
+    ActiveKernel().fun(seq.data(), seq.length(), output.data());
+    return output;
+}
+
+/*!
+    Write the reverse complement of \a seq to \a out, a buffer of
+    seq.length() bytes which must not overlap \a seq.
+ */
+void ReverseComplement(const std::string_view seq, char *out)
+{
+    ActiveKernel().fun(seq.data(), seq.length(), out);
+}
+
+/*!
+    Replace the \a n bytes at \a seq by their reverse complement, swapping
+    blocks from both ends through a small buffer. If a byte is not a
+    nucleotide, UnknownNucleotideError is thrown and \a seq is left partly
+    converted.
+ */
+void ReverseComplementInPlace(char *seq, const size_t n)
+{
+    char buffer[2 * SWAP_LENGTH];
+    const ReverseComplementFuncPtr fun = ActiveKernel().fun;
+
+    size_t i = 0;
+    for (; 2 * (i + SWAP_LENGTH) <= n; i += SWAP_LENGTH) {
+        char *back = seq + n - i - SWAP_LENGTH;
+        std::memcpy(buffer, seq + i, SWAP_LENGTH);
+        fun(back, SWAP_LENGTH, seq + i);
+        fun(buffer, SWAP_LENGTH, back);
+    }
+
+    // Less than two blocks are left in the middle.
+    size_t middle = n - 2 * i;
+    std::memcpy(buffer, seq + i, middle);
+    fun(buffer, middle, seq + i);
+}
+
+void ReverseComplementInPlace(std::string &seq)
+{
+    ReverseComplementInPlace(seq.data(), seq.length());
+}
+
+/*!
+    Hand the reverse complement of \a seq to \a sink in pieces of at most
+    \a chunk_length bytes, starting from the end of \a seq. Only one piece
+    is held besides \a seq, so a chromosome can be written out without a
+    second copy of it.
+ */
+void ReverseComplementChunks(const std::string_view seq,
+    const std::function<void(std::string_view)> &sink, const size_t chunk_length)
+{
+    std::string chunk(std::min(seq.length(), std::max<size_t>(chunk_length, 1)), '\0');
+    for (size_t end = seq.length(); end > 0; ) {
+        size_t n = std::min(end, chunk.length());
+        end -= n;
+        ActiveKernel().fun(seq.data() + end, n, chunk.data());
+        sink(std::string_view(chunk.data(), n));
+    }
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
@@ -0,0 +1,36 @@
+#ifndef LIB_REVCOMP_H
+#define LIB_REVCOMP_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "global.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    Complement of a nucleotide: A and T (or U) pair, C and G pair, and the
+    IUPAC ambiguity codes map to the code of the complementary set, such
+    as R (A or G) to Y (C or T). N, S and W are their own complement, as
+    are the gap characters '-' and '.'. Case is kept, so soft-masked
+    regions stay lower case. Any other byte throws UnknownNucleotideError.
+ */
+char Complement(const char base);
+
+std::string ReverseComplement(const std::string_view seq);
+void ReverseComplement(const std::string_view seq, char *out);
+void ReverseComplementInPlace(char *seq, const size_t n);
+void ReverseComplementInPlace(std::string &seq);
+void ReverseComplementChunks(const std::string_view seq,
+    const std::function<void(std::string_view)> &sink, const size_t chunk_length = 1 << 16);
+
+/*!
+    Name of the kernel used by ReverseComplement(): "avx2", "ssse3" or
+    "scalar".
+ */
+const char *ReverseComplementKernel() noexcept;
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_REVCOMP_H
@@ -0,0 +1,174 @@
+#include "search.h"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BIOUTILS_HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    Position of the first occurrence of \a pattern (\a m bytes, at least 2)
+    in the \a n bytes at \a text starting at or after \a from, or npos.
+ */
+typedef size_t (*FindKernelFuncPtr)(const char *, const size_t, const char *, const size_t, size_t);
+
+static size_t FindScalar(const char *text, const size_t n, const char *pattern, const size_t m, size_t from) noexcept
+{
+    const char *end = text + n - m + 1;
+    for (const char *p = text + from; p < end; p++) {
+        p = static_cast<const char *>(std::memchr(p, pattern[0], end - p));
+        if (!p)
+            break;
+        if (p[m - 1] == pattern[m - 1] && std::memcmp(p + 1, pattern + 1, m - 2) == 0)
+            return p - text;
+    }
+
+    return ExactMatcher::npos;
+}
+
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+
+__attribute__((target("sse2")))
+static size_t FindSSE2(const char *text, const size_t n, const char *pattern, const size_t m, size_t from) noexcept
+{
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[m - 1]);
+
+    size_t starts = n - m + 1;
+    for (; from + 16 <= starts; from += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + from));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + from + m - 1));
+        unsigned int mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+
+        for (; mask != 0; mask &= mask - 1) {
+            size_t i = from + __builtin_ctz(mask);
+            if (std::memcmp(text + i + 1, pattern + 1, m - 2) == 0)
+                return i;
+        }
+    }
+
+    return FindScalar(text, n, pattern, m, from);
+}
+
+__attribute__((target("avx2")))
+static size_t FindAVX2(const char *text, const size_t n, const char *pattern, const size_t m, size_t from) noexcept
+{
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[m - 1]);
+
+    size_t starts = n - m + 1;
+    for (; from + 32 <= starts; from += 32) {
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + from));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + from + m - 1));
+        unsigned int mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+
+        for (; mask != 0; mask &= mask - 1) {
+            size_t i = from + __builtin_ctz(mask);
+            if (std::memcmp(text + i + 1, pattern + 1, m - 2) == 0)
+                return i;
+        }
+    }
+
+    return FindSSE2(text, n, pattern, m, from);
+}
+
+#endif // BIOUTILS_HAVE_X86_KERNELS
+
+static FindKernelFuncPtr SelectFindKernel() noexcept
+{
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return FindAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return FindSSE2;
+#endif
+    return FindScalar;
+}
+
+static FindKernelFuncPtr FindKernel() noexcept
+{
+    static const FindKernelFuncPtr kernel = SelectFindKernel();
+    return kernel;
+}
+
+ExactMatcher::ExactMatcher(const std::string_view pattern) : m_pattern(pattern)
+{
+    size_t m = m_pattern.length();
+    if (m < QGRAM_MIN_LENGTH)
+        return;
+
+    // Shift aligning the rightmost earlier occurrence of each q-gram with
+    // the end of the window, or the whole window if it does not occur.
+    size_t last = m - QGRAM;
+    m_shifts.assign(QGRAM_TABLE_SIZE, static_cast<uint32_t>(last + 1));
+    for (size_t i = 0; i < last; i++)
+        m_shifts[qgramHash(m_pattern.data() + i)] = static_cast<uint32_t>(last - i);
+
+    size_t last_hash = qgramHash(m_pattern.data() + last);
+    m_shift_after_match = m_shifts[last_hash];
+    m_shifts[last_hash] = 0;
+}
+
+size_t ExactMatcher::qgramHash(const char *p) noexcept
+{
+    uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return (word * 2654435761U) >> 20;
+}
+
+size_t ExactMatcher::find(const std::string_view text, const size_t from) const noexcept
+{
+    size_t m = m_pattern.length();
+    if (m == 0 || text.length() < m || from > text.length() - m)
+        return npos;
+
+    if (m == 1) {
+        auto p = std::memchr(text.data() + from, m_pattern[0], text.length() - from);
+        return p ? static_cast<const char *>(p) - text.data() : npos;
+    }
+
+    if (m_shifts.empty())
+        return findShort(text, from);
+    else
+        return findLong(text, from);
+}
+
+size_t ExactMatcher::findShort(const std::string_view text, size_t from) const noexcept
+{
+    return FindKernel()(text.data(), text.length(), m_pattern.data(), m_pattern.length(), from);
+}
+
+size_t ExactMatcher::findLong(const std::string_view text, size_t from) const noexcept
+{
+    const char *data = text.data();
+    size_t m = m_pattern.length();
+    size_t starts = text.length() - m + 1;
+
+    while (from < starts) {
+        size_t shift = m_shifts[qgramHash(data + from + m - QGRAM)];
+        if (shift == 0) {
+            // Different q-grams may share a hash, so compare it all.
+            if (std::memcmp(data + from, m_pattern.data(), m) == 0)
+                return from;
+            shift = m_shift_after_match;
+        }
+        from += shift;
+    }
+
+    return npos;
+}
+
+size_t ExactMatcher::count(const std::string_view text) const noexcept
+{
+    size_t n = 0;
+    forEach(text, [&n](const size_t) { n++; });
+    return n;
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
@@ -0,0 +1,81 @@
+#ifndef LIB_SEARCH_H
+#define LIB_SEARCH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "global.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    \brief Exact search of one pattern, compiled once and run on any text.
+
+    Short patterns are found by comparing the first and the last byte of
+    the pattern against 16 or 32 candidate positions at once with SSE2 or
+    AVX2 (memchr on other CPUs), and verifying the candidates with memcmp.
+    Patterns of at least QGRAM_MIN_LENGTH bytes use Horspool's algorithm
+    on 4-byte q-grams, whose shifts stay long on a 4-letter alphabet where
+    single-byte shifts would not. Bytes are compared as they are.
+ */
+class ExactMatcher {
+
+public:
+    static constexpr size_t npos = std::string_view::npos;
+    static constexpr size_t QGRAM_MIN_LENGTH = 32;
+
+    explicit ExactMatcher(const std::string_view pattern);
+
+    const std::string &pattern() const noexcept { return m_pattern; }
+
+    /*!
+        Return the position of the first occurrence of the pattern in
+        \a text starting at or after \a from, or npos.
+     */
+    size_t find(const std::string_view text, const size_t from = 0) const noexcept;
+
+    /*!
+        Call \a fn(i) for the position \a i of every occurrence, overlapping
+        ones included, in increasing order.
+     */
+    template <typename Fn>
+    void forEach(const std::string_view text, Fn fn) const
+    {
+        for (size_t i = find(text); i != npos; i = find(text, i + 1))
+            fn(i);
+    }
+
+    size_t count(const std::string_view text) const noexcept;
+
+private:
+    static constexpr int QGRAM = 4;
+    static constexpr size_t QGRAM_TABLE_SIZE = 4096;
+
+    static size_t qgramHash(const char *p) noexcept;
+    size_t findShort(const std::string_view text, size_t from) const noexcept;
+    size_t findLong(const std::string_view text, size_t from) const noexcept;
+
+    std::string m_pattern;
+    // Horspool shifts by q-gram hash, for long patterns only.
+    std::vector<uint32_t> m_shifts;
+    size_t m_shift_after_match = 1;
+};
+
+/*!
+    Call \a fn(i) for the starting position \a i of every occurrence of
+    \a pattern in \a text.
+ */
+template <typename Fn>
+inline void ForEachMatch(const std::string_view text, const std::string_view pattern, Fn fn)
+{
+    if (pattern.empty() || pattern.length() > text.length())
+        return;
+
+    ExactMatcher(pattern).forEach(text, fn);
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_SEARCH_H
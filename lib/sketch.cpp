@@ -0,0 +1,256 @@
+#include "sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "counter.h"
+#include "pattern.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+// Keeps MixHash() from mapping the code of AAA...A to 0.
+static const hash_t SKETCH_SEED = 0x9e3779b97f4a7c15ULL;
+
+static const int MIN_PRECISION = 4;
+static const int MAX_PRECISION = 18;
+
+/*!
+    \a width is rounded up to a power of two.
+ */
+CountMinSketch::CountMinSketch(const size_t width, const int depth)
+    : m_depth(depth)
+{
+    if (width == 0 || depth <= 0)
+        throw std::runtime_error("The width and depth of a count-min sketch must be positive.");
+
+    size_t rounded = 1;
+    while (rounded < width)
+        rounded <<= 1;
+    m_mask = rounded - 1;
+    m_cells.assign(rounded * depth, 0);
+}
+
+/*!
+    Sketch whose estimates exceed the true count by more than \a epsilon
+    times the total count with a probability of at most \a delta, both in
+    (0, 1).
+ */
+CountMinSketch CountMinSketch::withError(const double epsilon, const double delta)
+{
+    if (!(epsilon > 0 && epsilon < 1 && delta > 0 && delta < 1))
+        throw std::runtime_error("The error and the failure probability of a count-min sketch must be in (0, 1).");
+
+    return CountMinSketch(static_cast<size_t>(std::ceil(std::exp(1.0) / epsilon)),
+                          static_cast<int>(std::ceil(std::log(1 / delta))));
+}
+
+/*!
+    Index of the counter of row \a row for a key of hash \a hash. Columns
+    are picked by double hashing: the two halves of one 64-bit hash give
+    the start and the odd step of the sequence of columns.
+ */
+size_t CountMinSketch::cell(const hash_t hash, const int row) const noexcept
+{
+    hash_t step = (hash >> 32) | 1;
+    return row * (m_mask + 1) + ((hash + row * step) & m_mask);
+}
+
+/*!
+    Count \a key \a count more times and return its new estimate.
+ */
+uint CountMinSketch::add(const hash_t key, const uint count) noexcept
+{
+    hash_t hash = MixHash(key ^ SKETCH_SEED);
+    uint32_t min = std::numeric_limits<uint32_t>::max();
+    for (int row = 0; row < m_depth; row++)
+        min = std::min(min, m_cells[cell(hash, row)]);
+
+    uint32_t target = min > std::numeric_limits<uint32_t>::max() - count
+        ? std::numeric_limits<uint32_t>::max() : min + count;
+    for (int row = 0; row < m_depth; row++) {
+        uint32_t &counter = m_cells[cell(hash, row)];
+        counter = std::max(counter, target);
+    }
+    return target;
+}
+
+uint CountMinSketch::estimate(const hash_t key) const noexcept
+{
+    hash_t hash = MixHash(key ^ SKETCH_SEED);
+    uint32_t min = std::numeric_limits<uint32_t>::max();
+    for (int row = 0; row < m_depth; row++)
+        min = std::min(min, m_cells[cell(hash, row)]);
+    return min;
+}
+
+/*!
+    Add the counts of \a other, which must have the same width and depth,
+    so that the sketch covers the keys of both.
+ */
+void CountMinSketch::merge(const CountMinSketch &other)
+{
+    if (other.m_mask != m_mask || other.m_depth != m_depth)
+        throw std::runtime_error("Can not merge count-min sketches of different sizes.");
+
+    for (size_t i = 0; i < m_cells.size(); i++) {
+        uint64_t sum = uint64_t(m_cells[i]) + other.m_cells[i];
+        m_cells[i] = static_cast<uint32_t>(std::min<uint64_t>(sum, std::numeric_limits<uint32_t>::max()));
+    }
+}
+
+/*!
+    \a precision must be in [4, 18].
+ */
+HyperLogLog::HyperLogLog(const int precision)
+    : m_precision(precision)
+{
+    if (precision < MIN_PRECISION || precision > MAX_PRECISION)
+        throw std::runtime_error("The precision of HyperLogLog must be in [4, 18].");
+
+    m_registers.assign(size_t(1) << precision, 0);
+}
+
+double HyperLogLog::standardError() const noexcept
+{
+    return 1.04 / std::sqrt(double(m_registers.size()));
+}
+
+void HyperLogLog::add(const hash_t key) noexcept
+{
+    hash_t hash = MixHash(key ^ SKETCH_SEED);
+    size_t index = hash >> (64 - m_precision);
+    // Rank of the first 1 bit after the index bits, at most 65 - precision.
+    hash_t rest = (hash << m_precision) | (hash_t(1) << (m_precision - 1));
+    uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    if (rank > m_registers[index])
+        m_registers[index] = rank;
+}
+
+double HyperLogLog::estimate() const noexcept
+{
+    const double m = static_cast<double>(m_registers.size());
+    double alpha;
+    switch (m_precision) {
+    case 4: alpha = 0.673; break;
+    case 5: alpha = 0.697; break;
+    case 6: alpha = 0.709; break;
+    default: alpha = 0.7213 / (1 + 1.079 / m); break;
+    }
+
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t reg : m_registers) {
+        sum += std::ldexp(1.0, -reg);
+        if (reg == 0) zeros++;
+    }
+
+    double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros != 0)
+        return m * std::log(m / zeros);
+    return raw;
+}
+
+/*!
+    Take in the keys of \a other, which must have the same precision.
+ */
+void HyperLogLog::merge(const HyperLogLog &other)
+{
+    if (other.m_precision != m_precision)
+        throw std::runtime_error("Can not merge HyperLogLogs of different precisions.");
+
+    for (size_t i = 0; i < m_registers.size(); i++)
+        m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+}
+
+KmerSketch::KmerSketch(const int k, const size_t top, const double epsilon, const double delta,
+                       const int precision, const bool canonical)
+    : m_k(k), m_canonical(canonical),
+      m_counts(CountMinSketch::withError(epsilon, delta)),
+      m_distinct(precision), m_top(top)
+{
+    if (k <= 0 || k > RollingKmer::MAX_K)
+        throw std::runtime_error("The length of k-mer must be in [1, 32].");
+}
+
+/*!
+    Count the k-mers of \a text. k-mers do not span two calls, so each
+    read of a read set is added on its own.
+ */
+void KmerSketch::add(const std::string_view text)
+{
+    ForEachKmer(text, m_k, [this](const size_t, const RollingKmer &kmer) {
+        hash_t code = m_canonical ? kmer.canonical() : kmer.forward();
+        uint count = m_canonical ? kmer.canonicalWeight() : 1;
+        uint estimate = m_counts.add(code, count);
+        m_distinct.add(code);
+        m_total += count;
+        if (m_top != 0)
+            track(code, estimate);
+    });
+}
+
+/*!
+    Keep \a code among the candidates if its \a estimate ranks it among
+    the top ones. Estimates only grow, so a k-mer which is not kept now
+    can only enter later with a higher one.
+ */
+void KmerSketch::track(const hash_t code, const uint estimate)
+{
+    // An estimate not above the lowest candidate can not enter, and if
+    // the k-mer is a candidate, that is already its estimate.
+    if (m_ranked.size() == m_top && estimate <= m_ranked.begin()->first)
+        return;
+
+    auto it = m_candidates.find(code);
+    if (it != m_candidates.end()) {
+        m_ranked.erase({it->second, code});
+        it->second = estimate;
+    } else {
+        if (m_ranked.size() == m_top) {
+            m_candidates.erase(m_ranked.begin()->second);
+            m_ranked.erase(m_ranked.begin());
+        }
+        m_candidates.emplace(code, estimate);
+    }
+    m_ranked.emplace(estimate, code);
+}
+
+/*!
+    Return the estimated count of \a kmer, regardless of its case, or 0 if
+    it is not a k-mer of ACGT bases.
+ */
+uint KmerSketch::estimate(const std::string_view kmer) const noexcept
+{
+    if (kmer.length() != static_cast<size_t>(m_k))
+        return 0;
+
+    RollingKmer rolling(m_k);
+    for (char base : kmer) {
+        if (!rolling.push(base))
+            return 0;
+    }
+
+    return m_counts.estimate(m_canonical ? rolling.canonical() : rolling.forward());
+}
+
+/*!
+    Return the tracked k-mers of highest estimate with their current
+    estimates, by decreasing estimate and in lexicographic order among
+    equal ones.
+ */
+std::vector<std::pair<std::string, uint>> KmerSketch::top() const
+{
+    std::vector<std::pair<std::string, uint>> output;
+    output.reserve(m_ranked.size());
+    for (auto it = m_ranked.rbegin(); it != m_ranked.rend(); ++it)
+        output.emplace_back(NumberToPatternBitwise(it->second, m_k), m_counts.estimate(it->second));
+
+    std::sort(output.begin(), output.end(), [](const auto &a, const auto &b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return output;
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
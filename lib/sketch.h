@@ -0,0 +1,138 @@
+#ifndef LIB_SKETCH_H
+#define LIB_SKETCH_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "global.h"
+#include "kmer.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    \brief Count-min sketch estimating the count of integer keys in a fixed
+    amount of memory.
+
+    \c depth rows of \c width 32-bit counters, each key being counted in
+    one counter per row picked by a hash of its own. The estimate of a key
+    is the smallest of its counters, which can only overestimate. With
+    width e / epsilon and depth ln(1 / delta), it exceeds the true count by
+    more than epsilon times the total count with a probability of at most
+    delta, whatever the number of distinct keys.
+
+    Counters are updated conservatively: a key only raises those of its
+    counters which are below its new estimate, which keeps the estimates
+    upper bounds while cutting the error left by colliding keys. A counter
+    saturates at the largest 32-bit value.
+ */
+class CountMinSketch {
+
+public:
+    CountMinSketch(const size_t width, const int depth);
+
+    static CountMinSketch withError(const double epsilon, const double delta);
+
+    size_t width() const noexcept { return m_mask + 1; }
+    int depth() const noexcept { return m_depth; }
+    size_t memory() const noexcept { return m_cells.size() * sizeof(uint32_t); }
+
+    uint add(const hash_t key, const uint count = 1) noexcept;
+    uint estimate(const hash_t key) const noexcept;
+    void merge(const CountMinSketch &other);
+
+private:
+    size_t cell(const hash_t hash, const int row) const noexcept;
+
+    size_t m_mask;
+    int m_depth;
+    std::vector<uint32_t> m_cells;
+};
+
+/*!
+    \brief HyperLogLog estimate of the number of distinct integer keys.
+
+    Keys are hashed to 64 bits. The first \c precision bits pick one of
+    2^precision one-byte registers, which keeps the longest run of leading
+    zero bits seen among the others. The harmonic mean of the registers
+    estimates the cardinality with a relative standard error of
+    1.04 / sqrt(2^precision), 0.8% for the default 16 KiB, and small
+    cardinalities are counted from the empty registers instead.
+ */
+class HyperLogLog {
+
+public:
+    explicit HyperLogLog(const int precision = 14);
+
+    int precision() const noexcept { return m_precision; }
+    size_t memory() const noexcept { return m_registers.size(); }
+    double standardError() const noexcept;
+
+    void add(const hash_t key) noexcept;
+    double estimate() const noexcept;
+    void merge(const HyperLogLog &other);
+
+private:
+    int m_precision;
+    std::vector<uint8_t> m_registers;
+};
+
+/*!
+    \brief Approximate k-mer counts of a stream of sequences in bounded
+    memory.
+
+    Every k-mer of the sequences handed to add() is counted by its 2-bit
+    code, or canonical code, in a CountMinSketch of error \a epsilon and
+    confidence 1 - \a delta, and in a HyperLogLog of \a precision for the
+    number of distinct k-mers. The \a top k-mers of highest estimate are
+    tracked as they are counted, so the most frequent k-mers of a read set
+    come out of a single pass without an exact table of all of them.
+    Memory does not grow with the input: it is that of the two sketches
+    plus \a top candidates. k-mers containing a non-ACGT byte are skipped,
+    and \a k must be in [1, 32].
+ */
+class KmerSketch {
+
+public:
+    KmerSketch(const int k, const size_t top = 0, const double epsilon = 1e-5, const double delta = 0.01,
+               const int precision = 14, const bool canonical = false);
+
+    int k() const noexcept { return m_k; }
+    size_t memory() const noexcept { return m_counts.memory() + m_distinct.memory(); }
+
+    void add(const std::string_view text);
+
+    /*!
+        Sum of the counts of all k-mers, which is the number of k-mers
+        counted unless canonical palindromes count twice.
+     */
+    uint64_t total() const noexcept { return m_total; }
+    double distinct() const noexcept { return m_distinct.estimate(); }
+    uint estimate(const std::string_view kmer) const noexcept;
+
+    std::vector<std::pair<std::string, uint>> top() const;
+
+    const CountMinSketch &counts() const noexcept { return m_counts; }
+
+private:
+    void track(const hash_t code, const uint estimate);
+
+    int m_k;
+    bool m_canonical;
+    CountMinSketch m_counts;
+    HyperLogLog m_distinct;
+    uint64_t m_total = 0;
+
+    // The candidates for the most frequent k-mers, by code and by estimate.
+    size_t m_top;
+    std::unordered_map<hash_t, uint> m_candidates;
+    std::set<std::pair<uint, hash_t>> m_ranked;
+};
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_SKETCH_H
@@ -0,0 +1,164 @@
+#include "skew.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BIOUTILS_HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+// Bases walked one by one after a kernel stops at a block.
+static const size_t WALK_LENGTH = 32;
+
+/*!
+    A skip kernel adds the skew of the whole blocks at the start of the
+    \a n bytes at \a p to \a skew, as long as a block can not bring it down
+    to \a minimum, and returns the number of bytes it skipped. Setting the
+    6th bit maps 'G' to 'g' and 'C' to 'c', and no other byte to either.
+ */
+typedef size_t (*SkewKernelFuncPtr)(const char *, const size_t, int64_t &, const int64_t);
+
+static size_t SkipScalar(const char *, const size_t, int64_t &, const int64_t) noexcept
+{
+    return 0;
+}
+
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+
+__attribute__((target("sse2")))
+static size_t SkipSSE2(const char *p, const size_t n, int64_t &skew, const int64_t minimum) noexcept
+{
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i g = _mm_set1_epi8('g');
+    const __m128i c = _mm_set1_epi8('c');
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)), lower);
+        int cs = __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(x, c)));
+        if (skew - cs <= minimum)
+            break;
+        skew += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(x, g))) - cs;
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t SkipAVX2(const char *p, const size_t n, int64_t &skew, const int64_t minimum) noexcept
+{
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i g = _mm256_set1_epi8('g');
+    const __m256i c = _mm256_set1_epi8('c');
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)), lower);
+        int cs = _mm_popcnt_u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, c)));
+        if (skew - cs <= minimum)
+            break;
+        skew += static_cast<int>(_mm_popcnt_u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, g)))) - cs;
+    }
+
+    return i;
+}
+
+#endif // BIOUTILS_HAVE_X86_KERNELS
+
+struct Kernel {
+    SkewKernelFuncPtr fun;
+    const char *name;
+};
+
+static Kernel SelectKernel() noexcept
+{
+#ifdef BIOUTILS_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        return {SkipAVX2, "avx2"};
+    if (__builtin_cpu_supports("sse2"))
+        return {SkipSSE2, "sse2"};
+#endif
+    return {SkipScalar, "scalar"};
+}
+
+static const Kernel &ActiveKernel() noexcept
+{
+    static const Kernel kernel = SelectKernel();
+    return kernel;
+}
+
+const char *SkewKernel() noexcept
+{
+    return ActiveKernel().name;
+}
+
+SkewScanner::SkewScanner(const size_t track_step)
+    : m_track_step(track_step)
+{
+    reset();
+}
+
+/*!
+    Start over with an empty genome, keeping the track step.
+ */
+void SkewScanner::reset()
+{
+    m_length = 0;
+    m_skew = m_minimum = 0;
+    m_minima.assign(1, 0);
+    m_track.clear();
+    if (m_track_step != 0) {
+        m_track.push_back(SkewPoint());
+        m_next_point = m_track_step;
+    }
+}
+
+/*!
+    Scan the next \a chunk of the genome.
+ */
+void SkewScanner::feed(const std::string_view chunk)
+{
+    const char *p = chunk.data();
+    size_t n = chunk.length();
+    while (n > 0) {
+        // Stop at the next point of the track.
+        size_t stop = m_track_step == 0 ? n : std::min(n, m_next_point - m_length);
+
+        size_t skipped = ActiveKernel().fun(p, stop, m_skew, m_minimum);
+        m_length += skipped;
+        size_t walked = std::min(stop - skipped, WALK_LENGTH);
+        walk(p + skipped, walked);
+
+        p += skipped + walked;
+        n -= skipped + walked;
+
+        if (m_track_step != 0 && m_length == m_next_point) {
+            m_track.push_back({m_length, m_skew});
+            m_next_point += m_track_step;
+        }
+    }
+}
+
+void SkewScanner::walk(const char *p, const size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        char base = p[i] | 0x20;
+        m_length++;
+        if (base == 'g') {
+            ++m_skew;
+            continue;
+        }
+
+        if (base == 'c' && --m_skew < m_minimum) {
+            m_minimum = m_skew;
+            m_minima.clear();
+        }
+        if (m_skew == m_minimum)
+            m_minima.push_back(m_length);
+    }
+}
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
@@ -0,0 +1,82 @@
+#ifndef LIB_SKEW_H
+#define LIB_SKEW_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "global.h"
+
+BIOUTILS_BEGIN_SUB_NAMESPACE(algorithms)
+
+/*!
+    Skew of a genome after its first \c position bases.
+ */
+struct SkewPoint {
+    size_t position = 0;
+    int64_t skew = 0;
+
+    bool operator==(const SkewPoint &other) const noexcept
+    {
+        return position == other.position && skew == other.skew;
+    }
+    bool operator!=(const SkewPoint &other) const noexcept { return !(*this == other); }
+};
+
+/*!
+    \brief Streaming skew of a genome read in chunks.
+
+    The skew after the first i bases is the number of G minus the number
+    of C among them, lower or upper case. Chunks are fed in genome order,
+    and only the running skew, its minimum and the positions reaching it
+    are kept, so memory grows with the number of minima rather than with
+    the genome. Positions count bases from 0, the skew before any base.
+
+    Bases are counted 32 or 16 at a time with AVX2 or SSE2, picked at run
+    time from what the CPU supports. A block is walked base by base only
+    when its C could bring the skew down to the minimum, which is rare
+    once the skew has moved away from it.
+
+    With a non-zero \a track_step, the skew at every multiple of
+    \a track_step is recorded too, a down-sampled track to plot the skew
+    of a whole genome.
+ */
+class SkewScanner {
+
+public:
+    explicit SkewScanner(const size_t track_step = 0);
+
+    void feed(const std::string_view chunk);
+    void reset();
+
+    size_t length() const noexcept { return m_length; }
+    int64_t skew() const noexcept { return m_skew; }
+    int64_t minimum() const noexcept { return m_minimum; }
+
+    /*!
+        Positions where the skew reaches minimum(), in increasing order.
+     */
+    const std::vector<size_t> &minima() const noexcept { return m_minima; }
+    const std::vector<SkewPoint> &track() const noexcept { return m_track; }
+    size_t trackStep() const noexcept { return m_track_step; }
+
+private:
+    void walk(const char *p, const size_t n);
+
+    size_t m_track_step;
+    size_t m_next_point = 0;
+    size_t m_length = 0;
+    int64_t m_skew = 0;
+    int64_t m_minimum = 0;
+    std::vector<size_t> m_minima;
+    std::vector<SkewPoint> m_track;
+};
+
+/*!
+    Name of the kernel used by SkewScanner: "avx2", "sse2" or "scalar".
+ */
+const char *SkewKernel() noexcept;
+
+BIOUTILS_END_SUB_NAMESPACE(algorithms)
+
+#endif // LIB_SKEW_H
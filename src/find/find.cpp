@@ -1,5 +1,6 @@
 #include <cstring>
 #include <cstdio>
+#include <cmath>
 #include <cctype>
 #include <map>
 #include <string>
@@ -10,7 +11,14 @@
 #include <CLI/CLI.hpp>
 
 #include "dataio.h"
+#include "fastx.h"
 #include "pattern.h"
+#include "ahocorasick.h"
+#include "clumps.h"
+#include "skew.h"
+#include "fmindex.h"
+#include "kmerdb.h"
+#include "sketch.h"
 #include "global.h"
 
 using namespace std;
@@ -20,32 +28,111 @@ using namespace std;
 using namespace BIOUTILS_NAMESPACE;
 
 size_t
-count(const string &text, const string &pattern, const int algorithm = 2)
+count(const string_view text, const string_view pattern, const int algorithm = 2, const int threads = 1)
 {
     size_t count;
     switch (algorithm)
     {
     case 1:
-        count = algorithms::PatternCount(text.c_str(), pattern.c_str(),
-            algorithms::AlgorithmEfficiency::Slow);
+        count = algorithms::PatternCount(text, pattern,
+            algorithms::AlgorithmEfficiency::Slow, threads);
         break;
     case 2:
-        count = algorithms::PatternCount(text.c_str(), pattern.c_str(),
-            algorithms::AlgorithmEfficiency::Fast);
+        count = algorithms::PatternCount(text, pattern,
+            algorithms::AlgorithmEfficiency::Fast, threads);
         break;
     case 3:
-        count = algorithms::PatternCount(text.c_str(), pattern.c_str(),
-            algorithms::AlgorithmEfficiency::Faster);
+        count = algorithms::PatternCount(text, pattern,
+            algorithms::AlgorithmEfficiency::Faster, threads);
         break;
     default:
-        count = algorithms::PatternCount(text.c_str(), pattern.c_str(),
-            algorithms::AlgorithmEfficiency::Fast);
+        count = algorithms::PatternCount(text, pattern,
+            algorithms::AlgorithmEfficiency::Fast, threads);
         break;
     }
 
     return count;
 }
 
+/*!
+    Call \a fn on each record of \a file_name, so every chromosome or read
+    of a FASTA/FASTQ file is processed on its own.
+ */
+template <typename Fn>
+void
+for_each_record(const string &file_name, Fn fn)
+{
+    IO::FastxReader reader(file_name);
+    IO::SequenceRecord record;
+    while (reader.next(record))
+        fn(record);
+}
+
+/*!
+    Results of a named record are prefixed with its name, so the output of
+    multi-record files can be told apart. Plain sequences stay unprefixed.
+ */
+ostream &
+record_prefix(ostream &out, const IO::SequenceRecord &record)
+{
+    if (!record.name.empty())
+        out << record.name << '\t';
+    return out;
+}
+
+/*!
+    Read the patterns of a multi-pattern search from \a file_name, either a
+    FASTA file whose records are labeled by name, or one pattern per line
+    labeled by itself. Blank lines are skipped. The input is read once, so
+    patterns can come from stdin (\c "-").
+
+    Patterns are matched byte for byte, like the default count algorithm;
+    only Rabin-Karp (-g 3) ignores case.
+ */
+vector<pair<string, string>>
+read_patterns(const string &file_name)
+{
+    vector<pair<string, string>> patterns;
+    string text = IO::read_input(file_name);
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == string::npos)
+        return patterns;
+
+    const bool fasta = text[first] == '>';
+    size_t begin = 0;
+    while (begin < text.length()) {
+        size_t end = text.find('\n', begin);
+        if (end == string::npos)
+            end = text.length();
+
+        string line = text.substr(begin, end - begin);
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        begin = end + 1;
+        if (line.empty())
+            continue;
+
+        if (!fasta)
+            patterns.emplace_back(line, line);
+        else if (line[0] == '>')
+            patterns.emplace_back(line.substr(1, line.find_first_of(" \t") - 1), string());
+        else if (!patterns.empty())
+            patterns.back().second += line;
+    }
+
+    return patterns;
+}
+
+algorithms::AhoCorasick
+build_automaton(const vector<pair<string, string>> &patterns)
+{
+    algorithms::AhoCorasick automaton;
+    for (const auto &p : patterns)
+        automaton.add(p.second);
+    automaton.build();
+    return automaton;
+}
+
 
 int
 main( int argc, char *argv[], char *envp[] )
@@ -53,78 +140,287 @@ main( int argc, char *argv[], char *envp[] )
     CLI::App app{PROGRAM_NAME};
 
     string pattern;
+    string pattern_file;
     string file_name = "-";
     int kmer;
     int algorithm = 2;
+    int threads = 1;
 
     app.add_option("file", file_name, "file contains sequences.");
     app.require_subcommand(1);
 
     CLI::App* count_subapp = app.add_subcommand("count", "Count pattern in the sequence");
     count_subapp->fallthrough();
-    count_subapp->add_option("-p,--pattern", pattern, "k-mer pattern to count.")->required();
-    count_subapp->add_option("-g,--algorithm", algorithm, "Algorithm to be applied.");
+    auto count_patterns = count_subapp->add_option_group("patterns");
+    count_patterns->add_option("-p,--pattern", pattern, "k-mer pattern to count.");
+    auto count_file_op = count_patterns->add_option("-P,--pattern-file", pattern_file,
+        "File of patterns to count in a single pass, one per line or FASTA. "
+        "Patterns match case-sensitively with one Aho-Corasick automaton.");
+    count_patterns->require_option(1);
+    count_subapp->add_option("-g,--algorithm", algorithm,
+        "Algorithm to be applied: 1 brute force, 2 exact matcher (default), "
+        "3 Rabin-Karp, which alone ignores case and never matches N.")
+        ->excludes(count_file_op);
+    count_subapp->add_option("-j,--threads", threads,
+        "Number of search threads, 0 means one per hardware thread.")
+        ->excludes(count_file_op);
     count_subapp->callback([&]() {
-        // Parse second positional argument.
-        string text;
-        if (file_name == "-") {
-            text = IO::read_stdin();
-        } else {
-            text = IO::read_file(file_name);
+        if (!pattern_file.empty()) {
+            auto patterns = read_patterns(pattern_file);
+            auto automaton = build_automaton(patterns);
+            for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+                auto counts = automaton.count(record.sequence);
+                for (size_t id = 0; id < patterns.size(); id++)
+                    record_prefix(cout, record) << patterns[id].first << '\t' << counts[id] << '\n';
+            });
+            cout << flush;
+            return;
         }
 
-        cout << count(text, pattern, algorithm) << endl;
+        for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+            record_prefix(cout, record) << count(record.sequence, pattern, algorithm, threads) << endl;
+        });
+    });
+
+    string index_output;
+    CLI::App* build_index_subapp = app.add_subcommand("build-index",
+        "Build an FM-index of the sequences for repeated searches with index --use-index");
+    build_index_subapp->fallthrough();
+    build_index_subapp->add_option("-o,--output", index_output, "File to write the index to.")->required();
+    build_index_subapp->callback([&]() {
+        algorithms::FMIndexWriter writer(index_output);
+        for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+            writer.write(record.name, record.comment, algorithms::FMIndex(record.sequence));
+        });
     });
 
     int hamming_distance = 0;
+    int edit_distance = -1;
+    string index_file;
     CLI::App* index_subapp = app.add_subcommand("index", "Get Index of Pattern in the Sequence");
     index_subapp->fallthrough();
-    index_subapp->add_option("-p,--pattern", pattern, "k-mer pattern to index.")->required();
-    index_subapp->add_option("-d,--hamming-distance", hamming_distance,
+    auto index_patterns = index_subapp->add_option_group("patterns");
+    index_patterns->add_option("-p,--pattern", pattern, "k-mer pattern to index.");
+    auto pattern_file_op = index_patterns->add_option("-P,--pattern-file", pattern_file,
+        "File of patterns to index in a single pass, one per line or FASTA. "
+        "Patterns match case-sensitively, as with -p.");
+    index_patterns->require_option(1);
+    auto hamming_op = index_subapp->add_option("-d,--hamming-distance", hamming_distance,
         "Find all approximate (less than or equal to d) occurrences of a pattern in a string.");
+    auto edit_op = index_subapp->add_option("-e,--edit-distance", edit_distance,
+        "Find all occurrences within edit distance e (mismatches, insertions "
+        "and deletions) of a pattern, reported by the index of their last base.")
+        ->excludes(hamming_op);
+    hamming_op->excludes(pattern_file_op);
+    index_subapp->add_option("-j,--threads", threads,
+        "Number of threads for exact search, 0 means one per hardware thread.")
+        ->excludes(pattern_file_op);
+    index_subapp->add_option("--use-index", index_file,
+        "Search the FM-index written by build-index instead of scanning the "
+        "sequences. Bases match regardless of case and N matches nothing.")
+        ->excludes(hamming_op)
+        ->excludes(edit_op);
     index_subapp->callback([&]() {
-        string seq = bioutils::IO::read_input(file_name);
-        seq.erase(std::remove(seq.begin(), seq.end(), '\n'), seq.end());
-        seq.erase(std::remove(seq.begin(), seq.end(), '\r'), seq.end());
-
-        std::vector<size_t> output;
-        if (hamming_distance > 0)
-            output = algorithms::PatternIndexApproximate(seq, pattern, hamming_distance);
-        else
-            output = algorithms::PatternIndex(seq, pattern);
-
-        for (size_t i : output) {
-            cout << i << " ";
+        if (!index_file.empty()) {
+            auto patterns = pattern_file.empty()
+                ? vector<pair<string, string>>{{pattern, pattern}}
+                : read_patterns(pattern_file);
+
+            algorithms::FMIndexReader reader(index_file);
+            algorithms::FMIndexRecord indexed;
+            IO::SequenceRecord record;
+            while (reader.next(indexed)) {
+                record.name = indexed.name;
+                for (const auto &p : patterns) {
+                    record_prefix(cout, record);
+                    if (!pattern_file.empty())
+                        cout << p.first << '\t';
+                    for (size_t i : indexed.index.locate(p.second))
+                        cout << i << ' ';
+                    cout << '\n';
+                }
+            }
+            cout << flush;
+            return;
         }
 
-        cout << endl;
+        if (!pattern_file.empty()) {
+            if (edit_distance >= 0)
+                throw CLI::ValidationError("--edit-distance", "not supported with --pattern-file");
+
+            auto patterns = read_patterns(pattern_file);
+            auto automaton = build_automaton(patterns);
+            for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+                auto positions = automaton.index(record.sequence);
+                for (size_t id = 0; id < patterns.size(); id++) {
+                    record_prefix(cout, record) << patterns[id].first << '\t';
+                    for (size_t i : positions[id])
+                        cout << i << ' ';
+                    cout << '\n';
+                }
+            });
+            cout << flush;
+            return;
+        }
+
+        for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+            const string &seq = record.sequence;
+
+            std::vector<size_t> output;
+            if (edit_distance >= 0)
+                output = algorithms::PatternIndexEditDistance(seq, pattern, edit_distance);
+            else if (hamming_distance > 0)
+                output = algorithms::PatternIndexApproximate(seq, pattern, hamming_distance);
+            else
+                output = algorithms::PatternIndex(seq, pattern, threads);
+
+            record_prefix(cout, record);
+            for (size_t i : output) {
+                cout << i << " ";
+            }
+
+            cout << endl;
+        });
     });
 
 
     bool rv = false;
     CLI::App* freq_subapp = app.add_subcommand("freq", "Find Most Frequent k-mer");
     freq_subapp->fallthrough();
-    freq_subapp->add_option("-k,--kmer", kmer, "Length of k-mer to find.")->required();
+    freq_subapp->add_option("-k,--kmer", kmer,
+        "Length of k-mer to find. Case is ignored and k-mers with a non-ACGT base are skipped.")->required();
     auto op = freq_subapp->add_option("-d,--hamming-distance", hamming_distance,
         "Find the Most Frequent Words with Mismatches (less than or equal to d) in a String.");
     freq_subapp->add_flag("-r,--reverse-complement", rv,
         "Frequent Words with Mismatches and Reverse Complements")
         ->needs(op);
+    freq_subapp->add_option("-j,--threads", threads,
+        "Number of counting threads, 0 means one per hardware thread.");
+    bool canonical = false;
+    auto canonical_op = freq_subapp->add_flag("-C,--canonical", canonical,
+        "Count a k-mer and its reverse complement together, and print the smaller of the two.");
+    size_t freq_top = 0;
+    uint min_count = 0;
+    auto top_op = freq_subapp->add_option("-n,--top", freq_top,
+        "Print the n most frequent k-mers with their counts, instead of those of the maximum count.")
+        ->excludes(op);
+    auto min_op = freq_subapp->add_option("-m,--min-count", min_count,
+        "Print every k-mer occurring at least m times with its count.")
+        ->excludes(op)->excludes(canonical_op)->excludes(top_op);
+    bool approx = false;
+    double epsilon = 1e-5, delta = 0.01;
+    int precision = 14;
+    auto approx_op = freq_subapp->add_flag("-a,--approx", approx,
+        "Estimate the k-mer counts of all the sequences together in bounded memory, and print the number "
+        "of distinct k-mers, the total count and the n most frequent k-mers (10 by default).")
+        ->excludes(op)->excludes(min_op);
+    freq_subapp->add_option("--epsilon", epsilon,
+        "Error of the approximate counts, as a fraction of the total count.")->needs(approx_op);
+    freq_subapp->add_option("--delta", delta,
+        "Probability of an approximate count exceeding its error.")->needs(approx_op);
+    freq_subapp->add_option("--precision", precision,
+        "Bits of HyperLogLog precision for the number of distinct k-mers, in [4, 18].")->needs(approx_op);
 
     freq_subapp->callback([&]() {
-        string seq = IO::read_input(file_name);
-        seq.erase(std::remove(seq.begin(), seq.end(), '\n'), seq.end());
-        seq.erase(std::remove(seq.begin(), seq.end(), '\r'), seq.end());
-
-        set<string> results;
-        if (hamming_distance > 0)
-            results = algorithms::FrequentWordsWithMismatches(seq, kmer, hamming_distance, rv);
-        else
-            results = algorithms::FrequentWords(seq, kmer);
-
-        for (auto kmer : results) {
-            cout << kmer << endl;
+        if (canonical && freq_top > 0 && !approx)
+            throw CLI::ValidationError("--canonical", "not supported with --top without --approx");
+
+        if (approx) {
+            algorithms::KmerSketch sketch(kmer, freq_top > 0 ? freq_top : 10, epsilon, delta, precision, canonical);
+            for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+                sketch.add(record.sequence);
+            });
+
+            cout << "distinct\t" << static_cast<uint64_t>(std::llround(sketch.distinct())) << '\n'
+                 << "total\t" << sketch.total() << '\n';
+            for (const auto &p : sketch.top())
+                cout << p.first << '\t' << p.second << '\n';
+            cout << flush;
+            return;
+        }
+
+        for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+            const string &seq = record.sequence;
+
+            if (freq_top > 0 || min_count > 0) {
+                auto ranked = freq_top > 0
+                    ? algorithms::TopFrequentWords(seq, kmer, freq_top, threads)
+                    : algorithms::FrequentWordsAtLeast(seq, kmer, min_count, threads);
+                for (const auto &p : ranked)
+                    record_prefix(cout, record) << p.first << '\t' << p.second << '\n';
+                cout << flush;
+                return;
+            }
+
+            set<string> results;
+            if (canonical) {
+                // The tables hold the canonical k-mer of each pair only.
+                auto table = hamming_distance > 0
+                    ? algorithms::FrequencyTableWithMismatches(seq, kmer, hamming_distance, true, true)
+                    : algorithms::FrequencyTable(seq, kmer, threads, true);
+                uint max = 0;
+                for (const auto &p : table)
+                    max = std::max(max, p.second);
+                for (const auto &p : table) {
+                    if (p.second == max) results.insert(p.first);
+                }
+            } else if (hamming_distance > 0)
+                results = algorithms::FrequentWordsWithMismatchesByKmerCounter(
+                    seq, kmer, hamming_distance, rv, threads);
+            else
+                results = algorithms::FrequentWords(seq, kmer,
+                    algorithms::AlgorithmEfficiency::Default, threads);
+
+            for (auto kmer : results) {
+                record_prefix(cout, record) << kmer << endl;
+            }
+        });
+    });
+
+    string db_file;
+    CLI::App* build_db_subapp = app.add_subcommand("build-db",
+        "Count the k-mers of all the sequences into a k-mer database for query-db and merge-db");
+    build_db_subapp->fallthrough();
+    build_db_subapp->add_option("-k,--kmer", kmer, "Length of k-mer to count.")->required();
+    build_db_subapp->add_option("-o,--output", db_file, "File to write the database to.")->required();
+    build_db_subapp->add_option("-j,--threads", threads,
+        "Number of counting threads, 0 means one per hardware thread.");
+    bool db_canonical = false;
+    build_db_subapp->add_flag("-C,--canonical", db_canonical,
+        "Count a k-mer and its reverse complement together.");
+    build_db_subapp->callback([&]() {
+        algorithms::KmerCounter counter(kmer);
+        for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+            counter.merge(algorithms::CountKmers(record.sequence, kmer, threads, db_canonical));
+        });
+        algorithms::WriteKmerDatabase(db_file, counter, db_canonical);
+    });
+
+    size_t top = 0;
+    CLI::App* query_db_subapp = app.add_subcommand("query-db",
+        "Print the count of a k-mer, or the most frequent k-mers, of a k-mer database");
+    query_db_subapp->add_option("--db", db_file, "Database written by build-db or merge-db.")->required();
+    auto query_op = query_db_subapp->add_option("-p,--pattern", pattern, "k-mer to look up.");
+    query_db_subapp->add_option("-n,--top", top, "Print the n most frequent k-mers.")->excludes(query_op);
+    query_db_subapp->callback([&]() {
+        algorithms::KmerDatabase db(db_file);
+        if (!pattern.empty()) {
+            cout << pattern << '\t' << db.count(pattern) << endl;
+            return;
         }
+
+        for (const auto &entry : db.top(top))
+            cout << algorithms::NumberToPatternBitwise(entry.first, db.k()) << '\t' << entry.second << '\n';
+        cout << flush;
+    });
+
+    vector<string> db_inputs;
+    CLI::App* merge_db_subapp = app.add_subcommand("merge-db",
+        "Merge k-mer databases of the same k, adding up their counts");
+    merge_db_subapp->add_option("-o,--output", db_file, "File to write the merged database to.")->required();
+    merge_db_subapp->add_option("-i,--input", db_inputs, "Databases to merge.")->required();
+    merge_db_subapp->callback([&]() {
+        algorithms::MergeKmerDatabases(db_file, db_inputs);
     });
 
     int k, window_length, times;
@@ -133,28 +429,72 @@ main( int argc, char *argv[], char *envp[] )
     clumps_subapp->add_option("-k,--k-mer", k, "a string pattern of length k")->required();
     clumps_subapp->add_option("-L,--window-length", window_length, "The length of a short interval of the genome")->required();
     clumps_subapp->add_option("-t,--times", times, "Pattern appears at least times")->required();
+    bool intervals = false;
+    clumps_subapp->add_flag("-i,--intervals", intervals,
+        "Print each clump region as k-mer, start and end on its own line.");
+    clumps_subapp->add_option("-j,--threads", threads,
+        "Number of threads, 0 means one per hardware thread.");
     clumps_subapp->callback([&]() {
-        string seq = bioutils::IO::read_input(file_name);
-        seq.erase(std::remove(seq.begin(), seq.end(), '\n'), seq.end());
-        seq.erase(std::remove(seq.begin(), seq.end(), '\r'), seq.end());
-
-        auto clumps = algorithms::FindClumps(seq, k, window_length, times);
-        for (auto clp : clumps)
-            std::cout << clp << " ";
-        std::cout << std::endl;
+        for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+            if (intervals) {
+                for (const auto &clump : algorithms::FindClumpIntervals(
+                        record.sequence, k, window_length, times, threads))
+                    record_prefix(cout, record) << clump.kmer << '\t' << clump.begin << '\t' << clump.end << '\n';
+                cout << flush;
+                return;
+            }
+
+            std::set<std::string> clumps;
+            if (threads == 1) {
+                clumps = algorithms::FindClumps(record.sequence, k, window_length, times);
+            } else {
+                for (const auto &clump : algorithms::FindClumpIntervals(
+                        record.sequence, k, window_length, times, threads))
+                    clumps.emplace(clump.kmer);
+            }
+            record_prefix(std::cout, record);
+            for (auto clp : clumps)
+                std::cout << clp << " ";
+            std::cout << std::endl;
+        });
     });
 
     CLI::App* skew_subapp = app.add_subcommand("skew", "Find a Position in a Genome Minimizing the Skew");
     skew_subapp->fallthrough();
+    size_t track_step = 0;
+    skew_subapp->add_option("-s,--track-step", track_step,
+        "Print the skew every given number of bases instead of its minima.");
+    skew_subapp->add_option("-j,--threads", threads,
+        "Number of threads for the minima, 0 means one per hardware thread.");
     skew_subapp->callback([&] {
-        string seq = bioutils::IO::read_input(file_name);
-        seq.erase(std::remove(seq.begin(), seq.end(), '\n'), seq.end());
-        seq.erase(std::remove(seq.begin(), seq.end(), '\r'), seq.end());
-
-        auto locations = algorithms::FindMinimumSkew(seq);
-        for (auto loc : locations)
-            std::cout << loc << ' ';
-        std::cout << std::endl;
+        // Concurrent chunks of a sequence need the whole of it.
+        if (threads != 1 && track_step == 0) {
+            for_each_record(file_name, [&](const IO::SequenceRecord &record) {
+                record_prefix(std::cout, record);
+                for (auto loc : algorithms::FindMinimumSkew(record.sequence, threads))
+                    std::cout << loc << ' ';
+                std::cout << std::endl;
+            });
+            return;
+        }
+
+        // Otherwise sequences are streamed, so whole chromosomes are never held.
+        IO::FastxReader reader(file_name);
+        IO::SequenceRecord record;
+        algorithms::SkewScanner scanner(track_step);
+        while (reader.next(record, [&scanner](std::string_view chunk) { scanner.feed(chunk); })) {
+            if (track_step != 0) {
+                for (const auto &point : scanner.track())
+                    record_prefix(cout, record) << point.position << '\t' << point.skew << '\n';
+                cout << flush;
+            } else {
+                record_prefix(std::cout, record);
+                for (auto loc : scanner.minima())
+                    std::cout << loc << ' ';
+                std::cout << std::endl;
+            }
+            scanner.reset();
+        }
     });
 
     CLI11_PARSE(app, argc, argv);
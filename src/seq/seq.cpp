@@ -6,6 +6,7 @@
 #include <CLI/CLI.hpp>
 
 #include "dataio.h"
+#include "fastx.h"
 #include "pattern.h"
 #include "exceptions.h"
 
@@ -15,6 +16,22 @@ using namespace bioutils;
 
 #define PROGRAM_NAME "bioseq - A tool to manipulate sequences."
 
+/*!
+    Write the FASTA header of a named record, so that multi-record input
+    produces multi-record output. Plain sequences have no header.
+ */
+static void
+print_header(const IO::SequenceRecord &record)
+{
+    if (record.name.empty())
+        return;
+
+    std::cout << '>' << record.name;
+    if (!record.comment.empty())
+        std::cout << ' ' << record.comment;
+    std::cout << '\n';
+}
+
 int
 main(int argc, char *argv[], char *envp[])
 {
@@ -33,37 +50,49 @@ main(int argc, char *argv[], char *envp[])
     conv_subapp->add_option("-d,--d-neighbors", hamming_distance, "Generate the d-Neighborhood of a String.");
     conv_subapp->add_flag("-H,--hash", do_hash, "Get hash number of the sequence.");
     conv_subapp->callback([&]() {
-        string seq = bioutils::IO::read_input(file_name);
+        IO::FastxReader reader(file_name);
+        IO::SequenceRecord record;
+        while (reader.next(record)) {
+            const string &seq = record.sequence;
+            print_header(record);
+
+            if (do_reverse_complement && !do_hash && hamming_distance == 0) {
+                // Written piece by piece, without a second copy of the
+                // sequence.
+                algorithms::ReverseComplementChunks(seq, [](const std::string_view chunk) {
+                    std::cout.write(chunk.data(), chunk.length());
+                });
+                std::cout << '\n';
+                continue;
+            }
 
-        seq.erase(std::remove(seq.begin(), seq.end(), '\n'), seq.end());
-        seq.erase(std::remove(seq.begin(), seq.end(), '\r'), seq.end());
+            string output(seq);
 
-        string output = seq;
+            if (do_reverse_complement)
+                output = algorithms::ReverseComplement(seq);
 
-        if (do_reverse_complement)
-            output = algorithms::ReverseComplement(seq);
+            if (do_hash && !output.empty()) {
+                auto hash = bioutils::algorithms::PatternToNumber(output);
+                std::cout << hash << std::endl;
+                std::cout << std::bitset<8*sizeof(hash)>(hash) << std::endl;
 
-        if (do_hash && !output.empty()) {
-            auto hash = bioutils::algorithms::PatternToNumber(output);
-            std::cout << hash << std::endl;
-            std::cout << std::bitset<8*sizeof(hash)>(hash) << std::endl;
+                for (int i = 0; i < (8*sizeof(hash)/2 - output.length()); i++) {
+                    std::cout << "  ";
+                }
 
-            for (int i = 0; i < (8*sizeof(hash)/2 - output.length()); i++) {
-                std::cout << "  ";
-            }
+                for (auto c : output) {
+                    std::cout << ' ' << c;
+                }
 
-            for (auto c : output) {
-                std::cout << ' ' << c;
-            }
-
-            std::cout << std::endl;
+                std::cout << std::endl;
 
-        } else if (hamming_distance > 0) {
-            auto neighbors = bioutils::algorithms::NeighborsRecursive(seq, hamming_distance);
-            for (auto n : neighbors)
-                std::cout << n << std::endl;
-        } else {
-            std::cout << output << std::endl;
+            } else if (hamming_distance > 0) {
+                auto neighbors = bioutils::algorithms::NeighborsRecursive(seq, hamming_distance);
+                for (auto n : neighbors)
+                    std::cout << n << std::endl;
+            } else {
+                std::cout << output << std::endl;
+            }
         }
     });
 
@@ -76,32 +105,34 @@ main(int argc, char *argv[], char *envp[])
     format_subapp->add_option("-P,--line-prefix", line_prefix, "Add prefix to each line.");
     format_subapp->add_option("-S,--line-suffix", line_suffix, "Add suffix to each line.");
     format_subapp->callback([&]() {
-        string seq = bioutils::IO::read_input(file_name);
-
-        seq.erase(std::remove(seq.begin(), seq.end(), '\n'), seq.end());
-        seq.erase(std::remove(seq.begin(), seq.end(), '\r'), seq.end());
-
-        int count = 0;
-        for (auto bp : seq) {
-            if (count == 0 && !line_prefix.empty())
-                std::cout << line_prefix;
-
-            std::cout << bp;
+        IO::FastxReader reader(file_name);
+        IO::SequenceRecord record;
+        while (reader.next(record)) {
+            const string &seq = record.sequence;
+            print_header(record);
+
+            int count = 0;
+            for (auto bp : seq) {
+                if (count == 0 && !line_prefix.empty())
+                    std::cout << line_prefix;
+
+                std::cout << bp;
+
+                if (++count == line_length) {
+                    if (!line_suffix.empty())
+                        std::cout << line_suffix;
+                    std::cout << std::endl;
+                    count = 0;
+                }
+            }
 
-            if (++count == line_length) {
+            if (count != 0) {
                 if (!line_suffix.empty())
                     std::cout << line_suffix;
+
                 std::cout << std::endl;
-                count = 0;
             }
         }
-
-        if (count != 0) {
-            if (!line_suffix.empty())
-                std::cout << line_suffix;
-
-            std::cout << std::endl;
-        }
     });
 
     CLI11_PARSE(app, argc, argv);
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <random>
 #include <iterator>
 #include <algorithm>
@@ -5,6 +6,11 @@
 #include "benchmark/benchmark.h"
 
 #include "pattern.h"
+#include "ahocorasick.h"
+#include "clumps.h"
+#include "fmindex.h"
+#include "kmerdb.h"
+#include "sketch.h"
 
 using namespace bioutils::algorithms;
 
@@ -53,6 +59,48 @@ void BenchPatternCount(benchmark::State& state, PatternCountFuncPtr fun) {
 
 BENCHMARK_CAPTURE(BenchPatternCount, BruteForce, PatternCount_BF)->RangeMultiplier(2)->Range(1024, 1024<<12);
 BENCHMARK_CAPTURE(BenchPatternCount, RabinKarp, PatternCount_RK)->RangeMultiplier(2)->Range(1024, 1024<<12);
+BENCHMARK_CAPTURE(BenchPatternCount, ByMatcher, PatternCountByMatcher)->RangeMultiplier(2)->Range(1024, 1024<<12);
+
+static void BenchPatternIndexByLength(benchmark::State& state, PatternCountFuncPtr fun) {
+    std::string genome = random_sequence(1 << 22);
+    std::string pattern = genome.substr(genome.length() / 2, state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fun(genome, pattern));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * genome.length());
+}
+
+BENCHMARK_CAPTURE(BenchPatternIndexByLength, BruteForce, PatternCount_BF)->Arg(4)->Arg(12)->Arg(32)->Arg(100)->Arg(1000);
+BENCHMARK_CAPTURE(BenchPatternIndexByLength, RabinKarp, PatternCount_RK)->Arg(4)->Arg(12)->Arg(32)->Arg(64)->Arg(100)->Arg(1000);
+BENCHMARK_CAPTURE(BenchPatternIndexByLength, ByMatcher, PatternCountByMatcher)->Arg(4)->Arg(12)->Arg(32)->Arg(100)->Arg(1000);
+
+static void BenchMultiPatternByPatternCount(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 20);
+    std::vector<std::string> patterns;
+    for (int i = 0; i < state.range(0); i++)
+        patterns.push_back(random_sequence(12));
+
+    for (auto _ : state) {
+        for (const auto &pattern : patterns)
+            benchmark::DoNotOptimize(PatternCount(genome, pattern, AlgorithmEfficiency::Fast));
+    }
+}
+
+static void BenchMultiPatternByAhoCorasick(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 20);
+    std::vector<std::string> patterns;
+    for (int i = 0; i < state.range(0); i++)
+        patterns.push_back(random_sequence(12));
+    AhoCorasick automaton(patterns);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(automaton.count(genome));
+    }
+}
+
+BENCHMARK(BenchMultiPatternByPatternCount)->Arg(10)->Arg(100);
+BENCHMARK(BenchMultiPatternByAhoCorasick)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
 
 /*
  * Benchmark for FrequentWords
@@ -73,6 +121,92 @@ BENCHMARK_CAPTURE(BenchFrequentWords, ByPerfectHash, FrequentWordsByPerfectHash)
 BENCHMARK_CAPTURE(BenchFrequentWords, BySorting, FrequentWordsBySorting)->RangeMultiplier(2)->Range(1024, 1024<<12);
 BENCHMARK_CAPTURE(BenchFrequentWords, ByStdHash, FrequentWordsByStdHash)->RangeMultiplier(2)->Range(1024, 1024<<12);
 
+// The 1000 most frequent 21-mers, against the maximum-count ones.
+void BenchTopFrequentWords(benchmark::State& state) {
+    std::string genome = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(TopFrequentWords(genome, 21, 1000));
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+void BenchFrequentWords21(benchmark::State& state, FrequentWordsFuncPtr fun) {
+    std::string genome = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fun(genome, 21));
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchTopFrequentWords)->Range(1 << 16, 1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BenchFrequentWords21, ByKmerCounter, +[](std::string_view text, int k) {
+    return FrequentWordsByKmerCounter(text, k);
+})->Range(1 << 16, 1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BenchFrequentWords21, BySorting, FrequentWordsBySorting)->Range(1 << 16, 1 << 22)->Unit(benchmark::kMillisecond);
+
+// A 16 Mbp genome with a planted repeat, so that few k-mers share the
+// maximum count and the time goes to counting rather than to the output.
+void BenchFrequentWordsLarge(benchmark::State& state, FrequentWordsFuncPtr fun) {
+    std::string genome = random_sequence(1 << 24);
+    std::string repeat = random_sequence(100);
+    for (size_t pos = 0; pos + 100 < genome.length(); pos += genome.length() / 50)
+        genome.replace(pos, 100, repeat);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fun(genome, state.range(0)));
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK_CAPTURE(BenchFrequentWordsLarge, BySorting, FrequentWordsBySorting)->Arg(12)->Arg(21)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BenchFrequentWordsLarge, ByKmerCounter, +[](std::string_view text, int k) {
+    return FrequentWordsByKmerCounter(text, k);
+})->Arg(12)->Arg(21)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BenchFrequentWordsLarge, ByStdHash, FrequentWordsByStdHash)->Arg(12)->Arg(21)->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark for PatternIndexApproximate
+ * ——————————————————————————————————————————————————
+ */
+
+static void BenchPatternIndexApproximate(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 20);
+    std::string pattern = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PatternIndexApproximate(genome, pattern, 3));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * genome.length());
+}
+
+static void BenchHammingDistance(benchmark::State& state) {
+    std::string a = random_sequence(state.range(0));
+    std::string b = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HammingDistance(a, b));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * a.length());
+}
+
+typedef std::vector<size_t> (*PatternIndexApproximateFuncPtr)(std::string_view, std::string_view, size_t);
+static void BenchApproximateSearch(benchmark::State& state, PatternIndexApproximateFuncPtr fun) {
+    std::string genome = random_sequence(1 << 20);
+    std::string pattern = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fun(genome, pattern, 3));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * genome.length());
+}
+
+BENCHMARK(BenchPatternIndexApproximate)->Arg(10)->Arg(20)->Arg(50)->Arg(200);
+BENCHMARK_CAPTURE(BenchApproximateSearch, ShiftAnd, PatternIndexApproximateShiftAnd)->Arg(20)->Arg(200);
+BENCHMARK_CAPTURE(BenchApproximateSearch, EditDistance, PatternIndexEditDistance)->Arg(20)->Arg(64)->Arg(200)->Arg(500);
+BENCHMARK(BenchHammingDistance)->Arg(20)->Arg(200)->Arg(2000);
+
 /*
  * Benchmark for FindClumps
  * ——————————————————————————————————————————————————
@@ -89,4 +223,294 @@ void BenchFindClumps(benchmark::State& state, FindClumpsFuncPtr fun) {
 }
 
 BENCHMARK_CAPTURE(BenchFindClumps, WithPerfectHash, FindClumpsBetterWithPerfectHash)->RangeMultiplier(2)->Range(1024, 1024<<12);
-BENCHMARK_CAPTURE(BenchFindClumps, WithStdHash, FindClumpsBetterWithStdHash)->RangeMultiplier(2)->Range(1024, 1024<<12);
\ No newline at end of file
+BENCHMARK_CAPTURE(BenchFindClumps, WithStdHash, FindClumpsBetterWithStdHash)->RangeMultiplier(2)->Range(1024, 1024<<12);
+
+// Genome of 4 Mbp, as E. coli, for windows of state.range(0) bases with
+// k = 20, on state.range(1) threads.
+void BenchFindClumpIntervals(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 22);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FindClumpIntervals(genome, 20, state.range(0), 3, state.range(1)));
+    }
+}
+
+BENCHMARK(BenchFindClumpIntervals)->ArgsProduct({{500, 50000}, {1, 4}})->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark for neighborhoods
+ * ——————————————————————————————————————————————————
+ */
+
+void BenchFrequencyTableWithMismatches(benchmark::State& state) {
+    std::string genome = random_sequence(10000);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FrequencyTableWithMismatches(genome, 10, state.range(0)));
+    }
+}
+
+BENCHMARK(BenchFrequencyTableWithMismatches)->DenseRange(1, 3)->Unit(benchmark::kMillisecond);
+
+// d = 2 with reverse complements, both strands (0) or canonical k-mers
+// only (1) in the table.
+void BenchFrequencyTableWithMismatchesRevComp(benchmark::State& state) {
+    std::string genome = random_sequence(10000);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FrequencyTableWithMismatches(genome, 10, 2, true, state.range(0)));
+    }
+}
+
+BENCHMARK(BenchFrequencyTableWithMismatchesRevComp)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// k = 12 and d = 2 on state.range(0) bases, with reverse complements.
+void BenchFrequentWordsWithMismatches(benchmark::State& state) {
+    std::string genome = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FrequentWordsWithMismatchesByKmerCounter(genome, 12, 2, true));
+    }
+}
+
+BENCHMARK(BenchFrequentWordsWithMismatches)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+void BenchNeighbors(benchmark::State& state) {
+    std::string pattern = random_sequence(12);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(NeighborsRecursive(pattern, state.range(0)));
+    }
+}
+
+BENCHMARK(BenchNeighbors)->DenseRange(1, 3);
+
+/*
+ * Benchmark for FindMinimumSkew
+ * ——————————————————————————————————————————————————
+ */
+
+void BenchFindMinimumSkew(benchmark::State& state) {
+    std::string genome = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FindMinimumSkew(genome));
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchFindMinimumSkew)->Range(1 << 20, 1 << 26);
+
+// Genomes of 1 Mbp to 1 Gbp, on one thread (-1 runs the serial overload)
+// and on every hardware thread (0).
+void BenchFindMinimumSkewParallel(benchmark::State& state) {
+    std::string genome = random_sequence(state.range(0));
+    int threads = state.range(1);
+
+    for (auto _ : state) {
+        if (threads < 0)
+            benchmark::DoNotOptimize(FindMinimumSkew(genome));
+        else
+            benchmark::DoNotOptimize(FindMinimumSkew(genome, threads));
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchFindMinimumSkewParallel)
+    ->ArgsProduct({benchmark::CreateRange(1 << 20, 1 << 30, 32), {-1, 0}})
+    ->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark for ReverseComplement
+ * ——————————————————————————————————————————————————
+ */
+
+void BenchReverseComplement(benchmark::State& state) {
+    std::string genome = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReverseComplement(genome));
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchReverseComplement)->Range(1 << 10, 1 << 26);
+
+void BenchReverseComplementInPlace(benchmark::State& state) {
+    std::string genome = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        ReverseComplementInPlace(genome);
+        benchmark::DoNotOptimize(genome.data());
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchReverseComplementInPlace)->Range(1 << 10, 1 << 26);
+
+/*
+ * Benchmark for FMIndex
+ * ——————————————————————————————————————————————————
+ */
+
+void BenchFMIndexBuild(benchmark::State& state) {
+    std::string genome = random_sequence(state.range(0));
+
+    for (auto _ : state) {
+        FMIndex index(genome);
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchFMIndexBuild)->Range(1 << 16, 1 << 24)->Unit(benchmark::kMillisecond);
+
+// Queries of 20 bases sampled from a 16 Mbp genome, by the FM-index and
+// by scanning the genome for each.
+static std::vector<std::string> sample_queries(const std::string &genome, const size_t n) {
+    std::vector<std::string> queries;
+    for (size_t i = 0; i < n; i++)
+        queries.push_back(genome.substr((i * 16411) % (genome.length() - 20), 20));
+    return queries;
+}
+
+void BenchFMIndexLocate(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 24);
+    std::vector<std::string> queries = sample_queries(genome, state.range(0));
+    FMIndex index(genome);
+
+    for (auto _ : state) {
+        for (const auto &query : queries)
+            benchmark::DoNotOptimize(index.locate(query));
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BenchPatternIndexQueries(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 24);
+    std::vector<std::string> queries = sample_queries(genome, state.range(0));
+    PackedSequence packed(genome);
+
+    for (auto _ : state) {
+        for (const auto &query : queries)
+            benchmark::DoNotOptimize(PatternIndex(packed, query));
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+BENCHMARK(BenchFMIndexLocate)->Arg(10)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BenchPatternIndexQueries)->Arg(10)->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark for KmerDatabase
+ * ——————————————————————————————————————————————————
+ */
+
+// Look up every k-mer of a 4 Mbp genome in the database of its counts,
+// dense for k = 10 and sparse for k = 21.
+void BenchKmerDatabaseLookup(benchmark::State& state) {
+    int k = state.range(0);
+    std::string genome = random_sequence(1 << 22);
+    std::string file_name = "bench-kmerdb.kdb";
+    WriteKmerDatabase(file_name, CountKmers(genome, k), false);
+    KmerDatabase db(file_name);
+
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        ForEachKmer(genome, k, [&](const size_t, const RollingKmer &kmer) {
+            sum += db.count(kmer.forward());
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * (genome.length() - k + 1));
+    std::remove(file_name.c_str());
+}
+
+BENCHMARK(BenchKmerDatabaseLookup)->Arg(10)->Arg(21)->Unit(benchmark::kMillisecond);
+
+void BenchKmerDatabaseWrite(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 22);
+    KmerCounter counter = CountKmers(genome, state.range(0));
+    std::string file_name = "bench-kmerdb.kdb";
+
+    for (auto _ : state) {
+        WriteKmerDatabase(file_name, counter, false);
+    }
+    state.SetItemsProcessed(state.iterations() * (genome.length() - state.range(0) + 1));
+    std::remove(file_name.c_str());
+}
+
+BENCHMARK(BenchKmerDatabaseWrite)->Arg(10)->Arg(21)->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark for KmerSketch
+ * ——————————————————————————————————————————————————
+ */
+
+// The 10 most frequent 21-mers of a 16 Mbp genome and its number of
+// distinct 21-mers, estimated in bounded memory against counted exactly.
+void BenchKmerSketch(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 24);
+
+    for (auto _ : state) {
+        KmerSketch sketch(21, 10);
+        sketch.add(genome);
+        benchmark::DoNotOptimize(sketch.top());
+        benchmark::DoNotOptimize(sketch.distinct());
+        state.counters["memory"] = sketch.memory();
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+void BenchKmerSketchExact(benchmark::State& state) {
+    std::string genome = random_sequence(1 << 24);
+
+    for (auto _ : state) {
+        KmerCounter counter = CountKmers(genome, 21);
+        TopCounts<hash_t> top(10);
+        counter.forEach([&top](const hash_t code, const uint count) { top.add(code, count); });
+        benchmark::DoNotOptimize(top.take());
+    }
+    state.SetBytesProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchKmerSketch)->Unit(benchmark::kMillisecond);
+BENCHMARK(BenchKmerSketchExact)->Unit(benchmark::kMillisecond);
+
+/*
+ * Benchmark for k-mer encoding
+ * ——————————————————————————————————————————————————
+ */
+
+void BenchKmerEncodingBySubstr(benchmark::State& state) {
+    auto k = state.range(0);
+    std::string genome = random_sequence(1 << 20);
+    std::string_view text = genome;
+
+    for (auto _ : state) {
+        hash_t sum = 0;
+        for (size_t i = 0; i + k <= text.length(); i++)
+            sum += PatternToNumber(text.substr(i, k), AlgorithmEfficiency::Fast);
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * genome.length());
+}
+
+void BenchKmerEncodingByRolling(benchmark::State& state) {
+    auto k = state.range(0);
+    std::string genome = random_sequence(1 << 20);
+
+    for (auto _ : state) {
+        hash_t sum = 0;
+        ForEachKmer(genome, k, [&](const size_t, const RollingKmer &kmer) {
+            sum += kmer.forward();
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * genome.length());
+}
+
+BENCHMARK(BenchKmerEncodingBySubstr)->Arg(10)->Arg(20)->Arg(31);
+BENCHMARK(BenchKmerEncodingByRolling)->Arg(10)->Arg(20)->Arg(31);
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ahocorasick.h"
+#include "pattern.h"
+
+namespace {
+
+using namespace bioutils::algorithms;
+
+TEST(TestAhoCorasick, NormalInput) {
+    AhoCorasick automaton({"he", "she", "his", "hers"});
+
+    EXPECT_EQ(automaton.size(), 4);
+    EXPECT_EQ(
+        automaton.index("ushers"),
+        std::vector<std::vector<size_t>>({{2}, {1}, {}, {2}})
+    );
+    EXPECT_EQ(automaton.count("hishershe"), std::vector<size_t>({2, 2, 1, 1}));
+}
+
+TEST(TestAhoCorasick, OverlapAndDuplicates) {
+    AhoCorasick automaton({"AA", "AAA", "A", "AA"});
+
+    EXPECT_EQ(
+        automaton.index("AAAA"),
+        std::vector<std::vector<size_t>>({{0, 1, 2}, {0, 1}, {0, 1, 2, 3}, {0, 1, 2}})
+    );
+
+    // Occurrences are reported by end position.
+    std::vector<std::pair<size_t, size_t>> matches;
+    automaton.search("AA", [&](const size_t id, const size_t position) {
+        matches.emplace_back(id, position);
+    });
+    typedef std::vector<std::pair<size_t, size_t>> Matches;
+    EXPECT_EQ(matches, Matches({{2, 0}, {0, 0}, {3, 0}, {2, 1}}));
+}
+
+TEST(TestAhoCorasick, MatchPatternIndex) {
+    std::string genome =
+        "CGGACTCGACAGATGTGAAGAAATGTGAAGACTGAGTGAA"
+        "GAGAAGAGGAAACACGACACGACATTGCGACATAATGTAC"
+        "GAATGTAATGTGCCTATGGCNNacgtGAAGA";
+
+    std::vector<std::string> patterns;
+    for (size_t i = 0; i + 6 <= genome.length(); i += 7) {
+        patterns.push_back(genome.substr(i, 3 + i % 4));
+        patterns.push_back(genome.substr(i + 1, 2));
+    }
+    patterns.push_back("TTTTTT");
+    patterns.push_back("acg");
+
+    AhoCorasick automaton(patterns);
+    auto positions = automaton.index(genome);
+    for (size_t id = 0; id < patterns.size(); id++)
+        EXPECT_EQ(positions[id], PatternIndex(genome, patterns[id])) << patterns[id];
+}
+
+TEST(TestAhoCorasick, EmptyInput) {
+    AhoCorasick nothing;
+    EXPECT_TRUE(nothing.empty());
+    EXPECT_EQ(nothing.count("ACGT"), std::vector<size_t>());
+
+    AhoCorasick automaton({"", "AC"});
+    EXPECT_EQ(automaton.count("ACAC"), std::vector<size_t>({0, 2}));
+    EXPECT_EQ(automaton.count(""), std::vector<size_t>({0, 0}));
+
+    // Patterns added after build() are picked up by the next build().
+    automaton.add("CA");
+    automaton.build();
+    EXPECT_EQ(automaton.count("ACAC"), std::vector<size_t>({0, 2, 1}));
+}
+
+} // namespace
@@ -0,0 +1,185 @@
+#include <string>
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+#include "dataio.h"
+#include "fastx.h"
+
+namespace {
+
+using namespace bioutils::IO;
+
+class TestInputBuffer : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove(file_name.c_str());
+    }
+
+    void write(const std::string &content) {
+        std::ofstream file(file_name, std::ios::binary);
+        file << content;
+    }
+
+    std::string file_name = "test-dataio-input.txt";
+};
+
+TEST_F(TestInputBuffer, MapRegularFile) {
+    write("ACGTACGT\nTTGCA\r\nGG");
+
+    InputBuffer input(file_name);
+    EXPECT_TRUE(input.isMapped());
+    EXPECT_EQ(input.size(), 18);
+    EXPECT_EQ(input.view(), "ACGTACGT\nTTGCA\r\nGG");
+    EXPECT_EQ(input.removeLineBreaks(), "ACGTACGTTTGCAGG");
+    EXPECT_EQ(input.size(), 15);
+    // Compacted into a buffer of its own, the file itself is untouched.
+    EXPECT_FALSE(input.isMapped());
+    EXPECT_EQ(read_file(file_name), "ACGTACGT\nTTGCA\r\nGG");
+}
+
+TEST_F(TestInputBuffer, WithoutLineBreaks) {
+    write("ACGTACGT");
+
+    InputBuffer input(file_name);
+    EXPECT_EQ(input.removeLineBreaks(), "ACGTACGT");
+    EXPECT_TRUE(input.isMapped());
+    EXPECT_EQ(read_input(file_name), "ACGTACGT");
+}
+
+TEST_F(TestInputBuffer, EmptyFile) {
+    write("");
+
+    InputBuffer input(file_name);
+    EXPECT_TRUE(input.empty());
+    EXPECT_EQ(input.removeLineBreaks(), "");
+}
+
+TEST_F(TestInputBuffer, MoveInput) {
+    write("ACGT\n");
+
+    InputBuffer input(file_name);
+    InputBuffer moved(std::move(input));
+    EXPECT_TRUE(input.empty());
+    EXPECT_EQ(moved.removeLineBreaks(), "ACGT");
+}
+
+TEST(TestInputBufferError, NonexistentFile) {
+    EXPECT_THROW(
+        InputBuffer("nonexistent-file.fa"),
+        std::runtime_error
+    );
+}
+
+// FASTA/FASTQ input goes through the same temporary file.
+class TestFastxReader : public TestInputBuffer {};
+
+TEST_F(TestFastxReader, ReadFastaRecords) {
+    write(
+        ">chr1 first chromosome\n"
+        "ACGTAC\n"
+        "GTTG\n"
+        "\n"
+        ">chr2\r\n"
+        "AAAA\r\n"
+        "CC\r\n");
+
+    FastxReader reader(file_name);
+    SequenceRecord record;
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.name, "chr1");
+    EXPECT_EQ(record.comment, "first chromosome");
+    EXPECT_EQ(record.sequence, "ACGTACGTTG");
+    EXPECT_EQ(record.quality, "");
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.name, "chr2");
+    EXPECT_EQ(record.comment, "");
+    EXPECT_EQ(record.sequence, "AAAACC");
+
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST_F(TestFastxReader, ReadFastqRecords) {
+    write(
+        "@read1 length=8\n"
+        "ACGT\n"
+        "ACGT\n"
+        "+\n"
+        "@III\n"
+        "IIII\n"
+        "@read2\n"
+        "GG\n"
+        "+read2\n"
+        "!!\n");
+
+    FastxReader reader(file_name);
+    SequenceRecord record;
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.name, "read1");
+    EXPECT_EQ(record.sequence, "ACGTACGT");
+    EXPECT_EQ(record.quality, "@IIIIIII");
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.name, "read2");
+    EXPECT_EQ(record.sequence, "GG");
+    EXPECT_EQ(record.quality, "!!");
+
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST_F(TestFastxReader, StreamRecordSequence) {
+    write(
+        "@read1\n"
+        "ACGT\n"
+        "AC\n"
+        "+\n"
+        "IIII\n"
+        "II\n"
+        ">chr1 first chromosome\n"
+        "ACGTAC\r\n"
+        "GTTG\n");
+
+    FastxReader reader(file_name);
+    SequenceRecord record;
+    std::string sequence;
+    auto append = [&sequence](std::string_view piece) { sequence.append(piece); };
+
+    ASSERT_TRUE(reader.next(record, append));
+    EXPECT_EQ(record.name, "read1");
+    EXPECT_EQ(record.sequence, "");
+    EXPECT_EQ(record.quality, "");
+    EXPECT_EQ(sequence, "ACGTAC");
+
+    sequence.clear();
+    ASSERT_TRUE(reader.next(record, append));
+    EXPECT_EQ(record.name, "chr1");
+    EXPECT_EQ(record.comment, "first chromosome");
+    EXPECT_EQ(sequence, "ACGTACGTTG");
+    EXPECT_FALSE(reader.next(record, append));
+}
+
+TEST_F(TestFastxReader, TruncatedFastq) {
+    write("@read1\nACGT\n+\nII\n");
+
+    FastxReader reader(file_name);
+    SequenceRecord record;
+    EXPECT_THROW(reader.next(record), std::runtime_error);
+}
+
+TEST_F(TestFastxReader, ReadPlainSequence) {
+    write("ACGT\nTTGG\nCC");
+
+    FastxReader reader(file_name);
+    SequenceRecord record;
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.name, "");
+    EXPECT_EQ(record.sequence, "ACGTTTGGCC");
+    EXPECT_FALSE(reader.next(record));
+}
+
+} // namespace
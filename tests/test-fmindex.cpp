@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "fmindex.h"
+
+#include "testutils.h"
+
+namespace {
+
+using namespace bioutils::algorithms;
+
+static std::vector<uint32_t> naive_suffix_array(const std::string_view text)
+{
+    std::vector<uint32_t> sa(text.length());
+    for (uint32_t i = 0; i < sa.size(); i++)
+        sa[i] = i;
+    std::sort(sa.begin(), sa.end(), [text](const uint32_t a, const uint32_t b) {
+        return text.substr(a) < text.substr(b);
+    });
+    return sa;
+}
+
+TEST(TestSuffixArray, HandleNormalInput) {
+    EXPECT_EQ(SuffixArray(""), std::vector<uint32_t>());
+    EXPECT_EQ(SuffixArray("A"), std::vector<uint32_t>({0}));
+    EXPECT_EQ(SuffixArray("banana"), std::vector<uint32_t>({5, 3, 1, 0, 4, 2}));
+    EXPECT_EQ(SuffixArray("mississippi"), naive_suffix_array("mississippi"));
+    EXPECT_EQ(SuffixArray("AAAAAAAAAA"), naive_suffix_array("AAAAAAAAAA"));
+}
+
+TEST(TestSuffixArray, MatchNaive) {
+    for (const std::string alphabet : {"AB", "ACGT", "ACGTNacgt\xff"}) {
+        for (size_t length : {2, 3, 17, 64, 1000, 5000}) {
+            std::string text = random_text(length, alphabet, length);
+            EXPECT_EQ(SuffixArray(text), naive_suffix_array(text)) << alphabet << ' ' << length;
+        }
+    }
+
+    // Long repeats make the LMS substrings repeat, so SA-IS recurses.
+    std::string repeat = random_text(50, "ACGT");
+    std::string text;
+    for (int i = 0; i < 40; i++)
+        text += repeat + (i % 3 == 0 ? "T" : "");
+    EXPECT_EQ(SuffixArray(text), naive_suffix_array(text));
+}
+
+// Case-insensitive search in which only ACGT bases match.
+static std::vector<size_t> naive_index(const std::string_view text, const std::string_view pattern)
+{
+    std::vector<size_t> output;
+    for (size_t i = 0; !pattern.empty() && i + pattern.length() <= text.length(); i++) {
+        bool match = true;
+        for (size_t j = 0; j < pattern.length() && match; j++) {
+            char base = ::toupper(text[i + j]);
+            match = base == ::toupper(pattern[j]) && std::string_view("ACGT").find(base) != std::string_view::npos;
+        }
+        if (match)
+            output.push_back(i);
+    }
+    return output;
+}
+
+TEST(TestFMIndex, MatchNaiveSearch) {
+    std::string text = random_text(20000, "ACGT");
+    text.replace(3000, 500, std::string(500, 'N'));
+    text.replace(9000, 100, random_text(100, "acgt"));
+    text.replace(12000, 40, std::string(40, 'A'));
+    text[15000] = 'R';
+    for (size_t pos : {100, 5000, 9050, 19990})
+        text.replace(pos, 10, "GATTACAGAT");
+
+    PackedSequence packed(text);
+    FMIndex index(packed);
+    EXPECT_EQ(index.size(), text.length());
+
+    std::vector<std::string> patterns = {
+        "GATTACAGAT", "gattacagat", "A", "C", "AAAAAAAA", "ACGT", text.substr(0, 60),
+        text.substr(19980), text.substr(9010, 20), "N", "ACGN", ""
+    };
+    for (size_t i = 0; i < 200; i++) {
+        size_t pos = (i * 7919) % (text.length() - 40);
+        patterns.push_back(text.substr(pos, 1 + i % 40));
+    }
+
+    for (const auto &pattern : patterns) {
+        auto expected = naive_index(text, pattern);
+        EXPECT_EQ(index.locate(pattern), expected) << pattern;
+        EXPECT_EQ(index.count(pattern), expected.size()) << pattern;
+    }
+}
+
+TEST(TestFMIndex, HandleShortSequences) {
+    EXPECT_EQ(FMIndex("").count("A"), 0);
+    EXPECT_EQ(FMIndex("A").locate("A"), std::vector<size_t>({0}));
+    EXPECT_EQ(FMIndex("ACGT").locate("ACGTA"), std::vector<size_t>());
+    EXPECT_EQ(FMIndex("NNNN").count("N"), 0);
+    EXPECT_EQ(FMIndex("AAAA").locate("AA"), std::vector<size_t>({0, 1, 2}));
+}
+
+TEST(TestFMIndex, SaveAndLoad) {
+    std::string genome = random_text(5000, "ACGTN");
+    FMIndex index(genome);
+
+    std::stringstream stream;
+    index.save(stream);
+    FMIndex loaded;
+    loaded.load(stream);
+    EXPECT_EQ(loaded.size(), index.size());
+    EXPECT_EQ(loaded.locate("ACG"), index.locate("ACG"));
+
+    std::string file_name = "test-fmindex.idx";
+    {
+        FMIndexWriter writer(file_name);
+        writer.write("chr1", "first", index);
+        writer.write("chr2", "", FMIndex("TTACGTT"));
+    }
+
+    FMIndexReader reader(file_name);
+    FMIndexRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.name, "chr1");
+    EXPECT_EQ(record.comment, "first");
+    EXPECT_EQ(record.index.locate("ACG"), index.locate("ACG"));
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.name, "chr2");
+    EXPECT_EQ(record.index.locate("ACG"), std::vector<size_t>({2}));
+    EXPECT_FALSE(reader.next(record));
+    std::remove(file_name.c_str());
+
+    EXPECT_THROW(FMIndexReader("test-fmindex-missing.idx"), std::runtime_error);
+}
+
+} // namespace
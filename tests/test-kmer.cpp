@@ -0,0 +1,334 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "counter.h"
+#include "kmer.h"
+#include "packedseq.h"
+#include "pattern.h"
+#include "utils.h"
+
+namespace {
+
+using namespace bioutils::algorithms;
+
+TEST(TestRollingKmer, NormalInput) {
+    std::string text = "ACGTTGCATGTCGCATGATGCATGAGAGCT";
+    const int k = 5;
+
+    RollingKmer rolling(k);
+    for (size_t i = 0; i < text.length(); i++) {
+        EXPECT_TRUE(rolling.push(text[i]));
+        if (i + 1 < k) {
+            EXPECT_FALSE(rolling.ready());
+            continue;
+        }
+
+        auto kmer = std::string_view(text).substr(i + 1 - k, k);
+        ASSERT_TRUE(rolling.ready());
+        EXPECT_EQ(rolling.forward(), PatternToNumber(kmer));
+        EXPECT_EQ(rolling.reverse(), PatternToNumber(ReverseComplement(kmer)));
+        EXPECT_EQ(rolling.canonical(), std::min(rolling.forward(), rolling.reverse()));
+    }
+}
+
+TEST(TestRollingKmer, MaxLength) {
+    std::string text(40, 'T');
+    RollingKmer rolling(32);
+    for (auto c : text)
+        rolling.push(c);
+
+    EXPECT_EQ(rolling.forward(), ~0ULL);
+    EXPECT_EQ(rolling.reverse(), 0ULL);
+}
+
+TEST(TestRollingKmer128, NormalInput) {
+    std::string text = "ACGTTGCATGTCGCATGATGCATGAGAGCTTAGCACGTTGCATGTCGCATGATGCATGAGAGCTT";
+
+    for (int k : {5, 32, 40, 64}) {
+        RollingKmer128 rolling(k);
+        for (auto c : text)
+            rolling.push(c);
+
+        auto kmer = std::string_view(text).substr(text.length() - k);
+        auto split = kmer.length() > 32 ? kmer.length() - 32 : 0;
+        EXPECT_TRUE(rolling.ready());
+        EXPECT_EQ(rolling.forward().high, PatternToNumber(kmer.substr(0, split)));
+        EXPECT_EQ(rolling.forward().low, PatternToNumber(kmer.substr(split)));
+    }
+
+    RollingKmer128 rolling(64);
+    for (auto c : std::string(70, 'T'))
+        rolling.push(c);
+    EXPECT_EQ(rolling.forward().high, ~0ULL);
+    EXPECT_EQ(rolling.forward().low, ~0ULL);
+}
+
+TEST(TestRollingKmerHash, NormalInput) {
+    std::string text = "ACGTTGCATGTCGCATGATGCATGAGAGCTTAGCACGTTGCATGTCGCATGATGCATGAGAGCTT";
+    const int k = 40;
+
+    // The rolled hash equals the hash of the k-mer pushed from scratch.
+    RollingKmerHash rolling(k);
+    for (size_t i = 0; i < text.length(); i++) {
+        EXPECT_TRUE(rolling.push(text[i]));
+        EXPECT_EQ(rolling.ready(), i + 1 >= k);
+        if (!rolling.ready())
+            continue;
+
+        RollingKmerHash fresh(k);
+        for (size_t j = i + 1 - k; j <= i; j++)
+            fresh.push(text[j]);
+        EXPECT_EQ(rolling.forward(), fresh.forward());
+    }
+
+    RollingKmerHash a(3), b(3);
+    for (char c : std::string("ACG")) a.push(c);
+    for (char c : std::string("acg")) b.push(c);
+    EXPECT_EQ(a.forward(), b.forward());
+    EXPECT_FALSE(a.push('N'));
+    EXPECT_FALSE(a.ready());
+}
+
+TEST(TestRollingKmer, ResetOnUnknownNucleotide) {
+    RollingKmer rolling(3);
+    EXPECT_TRUE(rolling.push('A'));
+    EXPECT_TRUE(rolling.push('C'));
+    EXPECT_FALSE(rolling.push('N'));
+    EXPECT_TRUE(rolling.push('g'));
+    EXPECT_TRUE(rolling.push('T'));
+    EXPECT_FALSE(rolling.ready());
+    EXPECT_TRUE(rolling.push('A'));
+    EXPECT_TRUE(rolling.ready());
+    EXPECT_EQ(rolling.forward(), PatternToNumber("GTA"));
+}
+
+TEST(TestPackedSequence, NormalInput) {
+    std::string text = "ACGTACGTTGCANNACGTACGTACGTACGTACGTACGTacgtRYA";
+    PackedSequence seq(text);
+
+    EXPECT_EQ(seq.size(), text.length());
+    EXPECT_TRUE(seq.hasAmbiguous());
+    EXPECT_EQ(seq.toString(), "ACGTACGTTGCANNACGTACGTACGTACGTACGTACGTACGTNNA");
+    EXPECT_EQ(seq.substr(40, 100), "GTNNA");
+    EXPECT_EQ(seq[12], 'N');
+    EXPECT_EQ(seq[14], 'A');
+}
+
+TEST(TestPackedSequence, Append) {
+    PackedSequence seq("ACGTACGTACGTACGTACGTACGTACG");
+    seq.append("TTTTTTTTTT");
+    seq.append("");
+    seq.append("GN");
+
+    EXPECT_EQ(seq.toString(), "ACGTACGTACGTACGTACGTACGTACGTTTTTTTTTTGN");
+    EXPECT_FALSE(PackedSequence("ACGT").hasAmbiguous());
+}
+
+TEST(TestPackedSequence, ExtractKmer) {
+    std::string text = "GATTACAGATTACAGATTACAGATTACAGATTACAGATTACANGATTACA";
+    PackedSequence seq(text);
+
+    hash_t code;
+    for (int k : {1, 5, 31, 32}) {
+        for (size_t i = 0; i + k <= text.length(); i++) {
+            auto kmer = std::string_view(text).substr(i, k);
+            if (kmer.find('N') != std::string_view::npos) {
+                EXPECT_FALSE(seq.kmer(i, k, code));
+            } else {
+                ASSERT_TRUE(seq.kmer(i, k, code));
+                EXPECT_EQ(code, PatternToNumber(kmer));
+            }
+        }
+        EXPECT_FALSE(seq.kmer(text.length() - k + 1, k, code));
+    }
+}
+
+TEST(TestKmerIterator, NormalInput) {
+    std::string text = "ACGTTNGCATGTCGCATGNNATGCATGAGAGCT";
+    PackedSequence seq(text);
+    const int k = 4;
+
+    std::vector<size_t> positions;
+    for (const auto &kmer : seq.kmers(k)) {
+        auto expected = std::string_view(text).substr(kmer.position, k);
+        EXPECT_EQ(kmer.forward, PatternToNumber(expected));
+        EXPECT_EQ(kmer.reverse, PatternToNumber(ReverseComplement(expected)));
+        positions.push_back(kmer.position);
+    }
+
+    EXPECT_EQ(
+        positions,
+        std::vector<size_t>({0, 1, 6, 7, 8, 9, 10, 11, 12, 13, 14, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29})
+    );
+}
+
+TEST(TestKmerIterator, EmptyInput) {
+    PackedSequence seq("ACG");
+    EXPECT_TRUE(seq.kmers(4).begin() == seq.kmers(4).end());
+    EXPECT_TRUE(PackedSequence().kmers(1).begin() == PackedSequence().kmers(1).end());
+}
+
+TEST(TestPackedSequence, PatternEntryPoints) {
+    std::string genome =
+        "CGGACTCGACAGATGTGAAGAAATGTGAAGACTGAGTGAA"
+        "GAGAAGAGGAAACACGACACGACATTGCGACATAATGTAC"
+        "GAATGTAATGTGCCTATGGC";
+    PackedSequence seq(genome);
+
+    EXPECT_EQ(PatternCount(seq, "GAAG"), PatternCount(genome, "GAAG", AlgorithmEfficiency::Fast));
+    EXPECT_EQ(PatternIndex(seq, "ATGT"), PatternIndex(genome, "ATGT"));
+    EXPECT_EQ(FrequencyArray(seq, 3), FrequencyArray(genome, 3));
+    EXPECT_EQ(FrequentWords(seq, 4), FrequentWords(genome, 4, AlgorithmEfficiency::Fast));
+    EXPECT_EQ(
+        FindClumps(seq, 5, 75, 4),
+        std::set<std::string>({"CGACA", "GAAGA", "AATGT"})
+    );
+
+    // k-mers overlapping an ambiguous base are not counted.
+    EXPECT_EQ(PatternCount(PackedSequence("AANAAA"), "AA"), 3);
+    EXPECT_EQ(FrequentWords(PackedSequence("ACGNACNAC"), 2), std::set<std::string>({"AC"}));
+}
+
+TEST(TestPackedSequence, PatternCaseAndAmbiguity) {
+    std::string text = "ACGTacgtACGTNNacgT";
+    PackedSequence seq(text);
+
+    // Strings are compared byte by byte, while packing drops the case of
+    // the text, so the packed overloads ignore case.
+    EXPECT_EQ(PatternIndex(text, "ACG"), std::vector<size_t>({0, 8}));
+    EXPECT_EQ(PatternIndex(text, "acg"), std::vector<size_t>({4, 14}));
+    EXPECT_EQ(PatternIndex(seq, "ACG"), std::vector<size_t>({0, 4, 8, 14}));
+    EXPECT_EQ(PatternIndex(seq, "acg"), PatternIndex(seq, "ACG"));
+    EXPECT_EQ(PatternCount(seq, "acg"), 4);
+
+    // A pattern holding N matches nothing in either, rather than throwing.
+    EXPECT_TRUE(PatternIndex(text, "TTTN").empty());
+    EXPECT_TRUE(PatternIndex(seq, "TTTN").empty());
+    EXPECT_TRUE(PatternIndex(seq, "GTN").empty());
+    EXPECT_EQ(PatternCount(seq, "GTN"), 0);
+}
+
+TEST(TestFlatCounter, NormalInput) {
+    FlatCounter<hash_t> counter;
+    EXPECT_TRUE(counter.empty());
+
+    // Enough keys to grow the table several times.
+    for (hash_t key = 0; key < 1000; key++) {
+        for (hash_t n = 0; n <= key % 3; n++)
+            counter[key * 7919]++;
+    }
+
+    EXPECT_EQ(counter.size(), 1000);
+    EXPECT_EQ(counter.count(0), 1);
+    EXPECT_EQ(counter.count(7919), 2);
+    EXPECT_EQ(counter.count(2 * 7919), 3);
+    EXPECT_EQ(counter.count(1), 0);
+
+    FlatCounter<hash_t> other;
+    other[7919] = 5;
+    other[1] = 1;
+    counter.merge(other);
+    EXPECT_EQ(counter.count(7919), 7);
+    EXPECT_EQ(counter.count(1), 1);
+
+    size_t total = 0;
+    counter.forEach([&total](const hash_t, const uint count) { total += count; });
+    EXPECT_EQ(total, 334 * 1 + 333 * 2 + 333 * 3 + 6);
+
+    counter.clear();
+    EXPECT_TRUE(counter.empty());
+    EXPECT_EQ(counter.count(7919), 0);
+}
+
+TEST(TestKmerCounter, Backend) {
+    EXPECT_TRUE(KmerCounter(8).isDense());
+    EXPECT_TRUE(KmerCounter(12).isDense());
+    EXPECT_FALSE(KmerCounter(13).isDense());
+    EXPECT_FALSE(KmerCounter(32).isDense());
+    // A small text does not fill a 4^12 array.
+    EXPECT_FALSE(KmerCounter(12, 1000).isDense());
+    EXPECT_TRUE(KmerCounter(12, 2000000).isDense());
+    // Up to 4^14, an array is smaller than a table of that many k-mers.
+    EXPECT_FALSE(KmerCounter::preferDense(14, 1000000));
+    EXPECT_TRUE(KmerCounter::preferDense(14, 100000000));
+    EXPECT_FALSE(KmerCounter::preferDense(15, 1000000000));
+}
+
+TEST(TestKmerCounter, NormalInput) {
+    std::string text = "ACGTTGCATGTCGCATGATGCATGAGAGCTACGTTGCATG";
+
+    for (int k : {4, 20}) {
+        KmerCounter counter(k);
+        ForEachKmer(text, k, [&counter](const size_t, const RollingKmer &kmer) {
+            counter.increment(kmer.forward());
+        });
+
+        auto expected = FrequencyTable(text, k);
+        size_t distinct = 0;
+        counter.forEach([&](const hash_t code, const uint count) {
+            EXPECT_EQ(count, expected[NumberToPatternBitwise(code, k)]);
+            distinct++;
+        });
+        EXPECT_EQ(distinct, expected.size());
+        EXPECT_EQ(counter.max(), bioutils::utils::MaxMap(expected));
+
+        hash_t code = PatternToNumber(text.substr(0, k));
+        counter.decrement(code);
+        EXPECT_EQ(counter.count(code), expected[text.substr(0, k)] - 1);
+    }
+}
+
+TEST(TestKmerTable, NormalInput) {
+    std::string text =
+        "ACGTTGCATGTCGCATGATGCATGAGAGCTTAGCACGTTGCATGTCGCATGATGCATGAGAGCTT"
+        "NACGTTGCATGTCGCATGATGCATGAGAGCTTAGCACGTTGCATGTCGCATGATGCATGAGAGCT";
+
+    for (int k : {3, 12, 32}) {
+        for (int threads : {1, 3}) {
+            KmerTable table(text, k, threads);
+            auto expected = FrequencyTable(text, k);
+            EXPECT_EQ(table.size(), expected.size());
+
+            table.forEach([&](const std::string &kmer, const uint count) {
+                EXPECT_EQ(count, expected[kmer]);
+                EXPECT_EQ(table.count(kmer), count);
+            });
+        }
+    }
+
+    // Count long k-mers by substring as reference.
+    for (int k : {33, 50, 64}) {
+        std::map<std::string, uint> expected;
+        for (size_t i = 0; i + k <= text.length(); i++) {
+            auto kmer = text.substr(i, k);
+            if (kmer.find('N') == std::string::npos)
+                expected[kmer]++;
+        }
+
+        for (int threads : {1, 4}) {
+            KmerTable128 table(text, k, threads);
+            EXPECT_EQ(table.size(), expected.size());
+            for (const auto &p : expected)
+                EXPECT_EQ(table.count(p.first), p.second);
+
+            std::map<std::string, uint> visited;
+            table.forEach([&](const std::string &kmer, const uint count) {
+                visited[kmer] = count;
+            });
+            EXPECT_EQ(visited, expected);
+        }
+    }
+
+    KmerTable table(text, 4);
+    EXPECT_EQ(table.count("ACGN"), 0);
+    EXPECT_EQ(table.count("ACG"), 0);
+    EXPECT_EQ(table.count("ttag"), table.count("TTAG"));
+    EXPECT_TRUE(KmerTable("ACG", 4).empty());
+    EXPECT_THROW(KmerTable(text, 33), std::runtime_error);
+    EXPECT_THROW(KmerTable128(text, 0), std::runtime_error);
+}
+
+} // namespace
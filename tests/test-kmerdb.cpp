@@ -0,0 +1,137 @@
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "kmerdb.h"
+#include "pattern.h"
+
+#include "testutils.h"
+
+namespace {
+
+using namespace bioutils::algorithms;
+
+static std::map<hash_t, uint> to_map(const KmerDatabase &db)
+{
+    std::map<hash_t, uint> counts;
+    db.forEach([&counts](const hash_t code, const uint count) { counts[code] = count; });
+    return counts;
+}
+
+static std::map<hash_t, uint> to_map(const KmerCounter &counter)
+{
+    std::map<hash_t, uint> counts;
+    counter.forEach([&counts](const hash_t code, const uint count) { counts[code] = count; });
+    return counts;
+}
+
+TEST(TestKmerDatabase, MatchCounter) {
+    std::string text = random_text(20000, "ACGTN");
+    std::string file_name = "test-kmerdb.kdb";
+
+    for (int k : {3, 8, 12, 13, 31}) {
+        for (bool canonical : {false, true}) {
+            KmerCounter counter = CountKmers(text, k, 1, canonical);
+            WriteKmerDatabase(file_name, counter, canonical);
+
+            KmerDatabase db(file_name);
+            EXPECT_EQ(db.k(), k);
+            EXPECT_EQ(db.isCanonical(), canonical);
+            if (k == 3 || k > KmerCounter::DENSE_MAX_K) {
+                EXPECT_EQ(db.isDense(), k == 3) << k;
+            }
+
+            auto expected = to_map(counter);
+            uint64_t total = 0;
+            for (const auto &p : expected)
+                total += p.second;
+            EXPECT_EQ(db.size(), expected.size());
+            EXPECT_EQ(db.total(), total);
+            EXPECT_EQ(to_map(db), expected) << k << ' ' << canonical;
+
+            for (size_t i = 0; i < 100; i++) {
+                std::string kmer = text.substr(i * 97, k);
+                if (kmer.find('N') != std::string::npos) {
+                    EXPECT_EQ(db.count(kmer), 0);
+                    continue;
+                }
+
+                hash_t code = PatternToNumber(kmer);
+                EXPECT_EQ(db.count(kmer), counter.count(canonical ? CanonicalCode(code, k) : code)) << kmer;
+            }
+        }
+    }
+
+    KmerDatabase db(file_name);
+    std::string kmer = text.substr(0, 31);
+    EXPECT_EQ(db.count(kmer), db.count(ReverseComplement(kmer)));
+    EXPECT_EQ(db.count(kmer.substr(1)), 0);
+    std::remove(file_name.c_str());
+}
+
+TEST(TestKmerDatabase, HandleTop) {
+    std::string file_name = "test-kmerdb.kdb";
+    WriteKmerDatabase(file_name, CountKmers("AAAACCCGGT", 1), false);
+
+    KmerDatabase db(file_name);
+    typedef std::vector<std::pair<hash_t, uint>> Entries;
+    EXPECT_EQ(db.top(0), Entries());
+    EXPECT_EQ(db.top(2), Entries({{0, 4}, {1, 3}}));
+    EXPECT_EQ(db.top(10), Entries({{0, 4}, {1, 3}, {2, 2}, {3, 1}}));
+
+    WriteKmerDatabase(file_name, CountKmers("ACGTACGTAC", 2), false);
+    KmerDatabase ties(file_name);
+    EXPECT_EQ(ties.top(3), Entries({{1, 3}, {6, 2}, {11, 2}}));
+    std::remove(file_name.c_str());
+}
+
+TEST(TestKmerDatabase, HandleMerge) {
+    std::vector<std::string> texts = {random_text(5000, "ACGT", 1), random_text(8000, "ACGT", 2), "ACGTACGT"};
+    std::vector<std::string> inputs = {"test-kmerdb-1.kdb", "test-kmerdb-2.kdb", "test-kmerdb-3.kdb"};
+    std::string output = "test-kmerdb-merged.kdb";
+
+    for (int k : {5, 20}) {
+        KmerCounter expected(k);
+        for (size_t i = 0; i < texts.size(); i++) {
+            KmerCounter counter = CountKmers(texts[i], k, 1, true);
+            WriteKmerDatabase(inputs[i], counter, true);
+            expected.merge(counter);
+        }
+
+        MergeKmerDatabases(output, inputs);
+        KmerDatabase merged(output);
+        EXPECT_EQ(merged.k(), k);
+        EXPECT_TRUE(merged.isCanonical());
+        EXPECT_EQ(to_map(merged), to_map(expected)) << k;
+        EXPECT_EQ(merged.total(), 5000 + 8000 - 2 * (k - 1) + (k <= 8 ? 9 - k : 0));
+    }
+
+    // Merging into one of the inputs replaces it once the merge is done.
+    std::string kmer = texts[0].substr(100, 20);
+    uint count = KmerDatabase(inputs[0]).count(kmer);
+    MergeKmerDatabases(inputs[0], {inputs[0], inputs[0]});
+    EXPECT_EQ(KmerDatabase(inputs[0]).count(kmer), 2 * count);
+    EXPECT_EQ(KmerDatabase(inputs[0]).total(), 2 * (5000 - 19));
+
+    WriteKmerDatabase(inputs[1], CountKmers(texts[1], 20, 1, false), false);
+    EXPECT_THROW(MergeKmerDatabases(output, inputs), std::runtime_error);
+
+    for (const auto &input : inputs)
+        std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(TestKmerDatabase, HandleInvalidFile) {
+    EXPECT_THROW(KmerDatabase("test-kmerdb-missing.kdb"), std::runtime_error);
+
+    std::string file_name = "test-kmerdb-invalid.kdb";
+    std::ofstream(file_name) << "BIOKMDB1 not really";
+    EXPECT_THROW(KmerDatabase db(file_name), std::runtime_error);
+    std::remove(file_name.c_str());
+}
+
+} // namespace
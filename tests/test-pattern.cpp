@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <cctype>
 #include <string>
 #include <set>
+#include <random>
+#include <tuple>
 #include <vector>
 #include <iostream>
 
@@ -7,6 +11,14 @@
 
 #include "pattern.h"
 #include "utils.h"
+#include "parallel.h"
+#include "hamming.h"
+#include "search.h"
+#include "clumps.h"
+#include "skew.h"
+#include "exceptions.h"
+
+#include "testutils.h"
 
 namespace {
 
@@ -106,7 +118,8 @@ TEST_P(TestPatternCount, NormalInput) {
 
 INSTANTIATE_TEST_SUITE_P(
     TestAllPatternCount, TestPatternCount,
-    Values(AlgorithmEfficiency::Slow, AlgorithmEfficiency::Fast, AlgorithmEfficiency::Faster),
+    Values(AlgorithmEfficiency::Slow, AlgorithmEfficiency::Fast, AlgorithmEfficiency::Faster,
+           AlgorithmEfficiency::Fastest),
     [](const testing::TestParamInfo<TestPatternCount::ParamType>& info) {
         switch (info.param)
         {
@@ -116,12 +129,38 @@ INSTANTIATE_TEST_SUITE_P(
             return "Fast";
         case AlgorithmEfficiency::Faster:
             return "Faster";
+        case AlgorithmEfficiency::Fastest:
+            return "Fastest";
         default:
             return "Unknown";
         }
     }
 );
 
+TEST(TestPatternCountRabinKarp, LongPatterns) {
+    std::string text = random_sequence(4000, 5);
+    std::string probe = text.substr(1000, 200);
+    // Copies of the probe, one in lower case, one broken by an N.
+    std::string lower = probe;
+    for (auto &c : lower) c = std::tolower(c);
+    text.replace(2000, 200, lower);
+    text.replace(3000, 200, probe);
+    text[3150] = 'N';
+
+    for (size_t len : {20, 32, 33, 50, 64, 65, 100, 200}) {
+        std::string pattern = probe.substr(0, len);
+        std::vector<size_t> expected = {1000, 2000};
+        if (len <= 150) expected.push_back(3000);
+
+        EXPECT_EQ(PatternIndex_RK(text, pattern), expected) << len;
+        EXPECT_EQ(PatternCount_RK(text, pattern), expected.size()) << len;
+    }
+
+    // Patterns with non-ACGT bytes never match, and do not throw.
+    EXPECT_EQ(PatternCount_RK("ACGNACGN", "ACGN"), 0);
+    EXPECT_EQ(PatternCount_RK(std::string(100, 'N'), std::string(70, 'N')), 0);
+}
+
 class TestFrequentWords : public TestWithParam<AlgorithmEfficiency> {
   // You can implement all the usual fixture class members here.
   // To access the test parameter, call GetParam() from class
@@ -277,6 +316,242 @@ INSTANTIATE_TEST_SUITE_P(
     }
 );
 
+TEST(TestSplitShards, NormalInput) {
+    auto shards = SplitShards("ACGTACGTAC", 3, 2);
+    EXPECT_EQ(
+        shards,
+        std::vector<std::string_view>({"ACGTA", "TACGT", "GTAC"})
+    );
+
+    EXPECT_EQ(SplitShards("AC", 4, 2).size(), 0);
+    EXPECT_EQ(SplitShards("ACG", 4, 2), std::vector<std::string_view>({"ACG"}));
+}
+
+TEST(TestFrequentWordsParallel, MatchSerial) {
+    std::string text = random_sequence(10007);
+
+    for (int threads : {2, 3, 8}) {
+        EXPECT_EQ(FrequencyArray(text, 5, threads), FrequencyArray(text, 5));
+        EXPECT_EQ(FrequencyTable(text, 7, threads), FrequencyTable(text, 7));
+        EXPECT_EQ(FrequentWordsByPerfectHash(text, 6, threads), FrequentWordsByPerfectHash(text, 6));
+        EXPECT_EQ(FrequentWordsByStdHash(text, 9, threads), FrequentWordsByStdHash(text, 9));
+        EXPECT_EQ(FrequentWordsBySorting(text, 9, threads), FrequentWordsBySorting(text, 9));
+    }
+
+    // Frequency array shards are at least 1 MiB long.
+    std::string genome = random_sequence(3 << 20);
+    EXPECT_EQ(FrequencyArray(genome, 8, 4), FrequencyArray(genome, 8));
+    EXPECT_EQ(FrequencyArray(genome, 8, 4, true), FrequencyArray(genome, 8, 1, true));
+
+    // More threads than k-mers.
+    EXPECT_EQ(FrequentWordsBySorting("ATGATGATG", 3, 16), std::set<std::string>({"ATG"}));
+    EXPECT_EQ(FrequentWordsByPerfectHash("ATGATGATG", 3, 16), std::set<std::string>({"ATG"}));
+    EXPECT_EQ(FrequencyTable("ATG", 3, 16), StrNumDict({{"ATG", 1}}));
+}
+
+TEST(TestRadixSort, MatchStdSort) {
+    std::mt19937_64 gen(7);
+    for (int bits : {1, 8, 11, 12, 21, 42, 63, 64}) {
+        for (size_t n : {0, 1, 255, 256, 5000, 100003}) {
+            hash_t mask = bits == 64 ? ~hash_t(0) : (hash_t(1) << bits) - 1;
+            std::vector<hash_t> keys(n);
+            for (auto &key : keys)
+                key = gen() & mask;
+            // Runs of equal keys, and buckets holding a single one.
+            for (size_t i = 0; i + 1 < n; i += 97)
+                keys[i + 1] = keys[i];
+
+            std::vector<hash_t> expected = keys;
+            std::sort(expected.begin(), expected.end());
+            for (int threads : {1, 3}) {
+                std::vector<hash_t> sorted = keys;
+                RadixSort(sorted, bits, threads);
+                EXPECT_EQ(sorted, expected) << bits << ' ' << n << ' ' << threads;
+            }
+        }
+    }
+}
+
+TEST(TestTopFrequentWords, MatchFrequencyTable) {
+    std::string text = random_sequence(5003);
+    for (size_t pos : {10, 1000, 2000, 3000})
+        text.replace(pos, 70, "GATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACA");
+
+    typedef std::vector<std::pair<std::string, uint>> Entries;
+    for (int k : {3, 8, 21, 40, 70}) {
+        // Every k-mer ranked by decreasing count, then lexicographically.
+        Entries ranked;
+        for (const auto &p : FrequencyTable(text, k))
+            ranked.push_back(p);
+        std::sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+
+        for (size_t n : {1, 10, 1000, 100000}) {
+            Entries expected(ranked.begin(), ranked.begin() + std::min(n, ranked.size()));
+            EXPECT_EQ(TopFrequentWords(text, k, n), expected) << k << ' ' << n;
+            EXPECT_EQ(TopFrequentWords(text, k, n, 3), expected) << k << ' ' << n;
+        }
+
+        for (uint min_count : {0, 2, 4, 5}) {
+            Entries expected;
+            std::copy_if(ranked.begin(), ranked.end(), std::back_inserter(expected),
+                [min_count](const auto &p) { return p.second >= min_count; });
+            EXPECT_EQ(FrequentWordsAtLeast(text, k, min_count), expected) << k << ' ' << min_count;
+        }
+    }
+
+    EXPECT_EQ(TopFrequentWords("ACGTACGTNACG", 3, 2), Entries({{"ACG", 3}, {"CGT", 2}}));
+    EXPECT_EQ(TopFrequentWords("ACGT", 3, 0), Entries());
+    EXPECT_EQ(TopFrequentWords("AC", 3, 5), Entries());
+    EXPECT_EQ(FrequentWordsAtLeast("ACGTACGTNACG", 3, 3), Entries({{"ACG", 3}}));
+}
+
+TEST(TestPatternSearchParallel, MatchSerial) {
+    std::string text = random_sequence(300007);
+    // Overlapping occurrences around every possible shard boundary.
+    for (size_t pos = 0; pos + 40 < text.length(); pos += 9973)
+        text.replace(pos, 40, std::string(40, 'A'));
+
+    for (std::string pattern : std::vector<std::string>({"AAAA", "ACG", "GATTACA", std::string(33, 'A')})) {
+        auto serial = PatternIndex(text, pattern);
+        ASSERT_FALSE(serial.empty());
+        for (int threads : {2, 3, 8}) {
+            EXPECT_EQ(PatternIndex(text, pattern, threads), serial);
+            for (auto algo : {AlgorithmEfficiency::Slow, AlgorithmEfficiency::Fast,
+                              AlgorithmEfficiency::Faster, AlgorithmEfficiency::Fastest})
+                EXPECT_EQ(PatternCount(text, pattern, algo, threads), serial.size());
+        }
+    }
+
+    EXPECT_EQ(PatternCount("ATGATGATG", "ATG", AlgorithmEfficiency::Fast, 16), 3);
+    EXPECT_EQ(PatternIndex("ATGATGATG", "TGA", 16), std::vector<size_t>({1, 4}));
+    EXPECT_EQ(PatternIndex("ATG", "ATGC", 4), std::vector<size_t>());
+}
+
+TEST(TestKmerCounter, MatchOtherBackends) {
+    std::string text = random_sequence(20011);
+    // Plant a repeat so that long k-mers have a clear winner.
+    std::string repeat = "ACGTTGCATGTCGCATGATGCATGAGAGCTTAGC";
+    for (size_t pos : {100, 5000, 5020, 12000})
+        text.replace(pos, repeat.length(), repeat);
+
+    for (int k : {3, 9, 14, 20, 32}) {
+        EXPECT_EQ(FrequentWordsByKmerCounter(text, k), FrequentWordsByStdHash(text, k));
+        EXPECT_EQ(FrequentWordsByKmerCounter(text, k, 3), FrequentWordsByStdHash(text, k));
+    }
+    EXPECT_EQ(FrequentWords(text, 20, AlgorithmEfficiency::Default), FrequentWordsByStdHash(text, 20));
+
+    for (int k : {4, 11, 20}) {
+        EXPECT_EQ(
+            FindClumpsWithKmerCounter(text, k, 500, 3),
+            FindClumpsBetterWithStdHash(text, k, 500, 3)
+        );
+    }
+
+    EXPECT_EQ(CountKmers(text, 14, 4).count(PatternToNumber(repeat.substr(0, 14))), 4);
+
+    // Longer than a hash_t, counted by 128-bit codes.
+    std::string repeat40 = repeat + repeat.substr(0, 6);
+    for (size_t pos : {300, 800, 900})
+        text.replace(pos, repeat40.length(), repeat40);
+    EXPECT_EQ(FrequentWordsByStdHash(text, 40), std::set<std::string>({repeat40}));
+    EXPECT_EQ(FrequentWords(text, 40, AlgorithmEfficiency::Default), std::set<std::string>({repeat40}));
+    EXPECT_EQ(FindClumps(text, 40, 640, 3), std::set<std::string>({repeat40}));
+    EXPECT_EQ(FindClumps(text, 40, 639, 3), std::set<std::string>());
+    EXPECT_THROW(CountKmers(text, 33), std::runtime_error);
+}
+
+// Union of the spans of every \a times consecutive occurrences fitting in
+// a window, per k-mer, straight from the definition.
+static std::vector<ClumpInterval> brute_force_clump_intervals(
+    const std::string_view genome, int k, int window_length, int times)
+{
+    std::map<std::string, std::vector<size_t>> occurrences;
+    for (size_t i = 0; i + k <= genome.length(); i++) {
+        std::string kmer(genome.substr(i, k));
+        std::transform(kmer.begin(), kmer.end(), kmer.begin(), ::toupper);
+        if (std::all_of(kmer.begin(), kmer.end(), [](char c) { return ISNTP(c); }))
+            occurrences[kmer].push_back(i);
+    }
+
+    std::vector<ClumpInterval> clumps;
+    for (const auto &p : occurrences) {
+        const auto &occ = p.second;
+        for (size_t j = 0; j + times <= occ.size(); j++) {
+            size_t begin = occ[j], end = occ[j + times - 1] + k;
+            if (end - begin > static_cast<size_t>(window_length))
+                continue;
+            if (!clumps.empty() && clumps.back().kmer == p.first && begin < clumps.back().end)
+                clumps.back().end = end;
+            else
+                clumps.push_back({p.first, begin, end});
+        }
+    }
+
+    std::sort(clumps.begin(), clumps.end(), [](const ClumpInterval &a, const ClumpInterval &b) {
+        return std::tie(a.begin, a.end, a.kmer) < std::tie(b.begin, b.end, b.kmer);
+    });
+    return clumps;
+}
+
+TEST(TestFindClumpIntervals, HandleNormalInput) {
+    typedef std::vector<ClumpInterval> Intervals;
+
+    EXPECT_EQ(FindClumpIntervals("AAAAAA", 2, 3, 2), Intervals({{"AA", 0, 6}}));
+    EXPECT_EQ(FindClumpIntervals("ATGCATGCCCCCATGCATG", 3, 7, 2),
+              brute_force_clump_intervals("ATGCATGCCCCCATGCATG", 3, 7, 2));
+
+    auto clumps = FindClumpIntervals("ATGNATGCCCCCCATGCATG", 3, 7, 2);
+    clumps.erase(std::remove_if(clumps.begin(), clumps.end(), [](const ClumpInterval &c) {
+        return c.kmer != "ATG";
+    }), clumps.end());
+    EXPECT_EQ(clumps, Intervals({{"ATG", 0, 7}, {"ATG", 13, 20}}));
+
+    std::string genome =
+        "CGGACTCGACAGATGTGAAGAAATGTGAAGACTGAGTGAA"
+        "GAGAAGAGGAAACACGACACGACATTGCGACATAATGTAC"
+        "GAATGTAATGTGCCTATGGC";
+    std::set<std::string> kmers;
+    for (const auto &clump : FindClumpIntervals(genome, 5, 75, 4))
+        kmers.emplace(clump.kmer);
+    EXPECT_EQ(kmers, std::set<std::string>({"CGACA", "GAAGA", "AATGT"}));
+
+    // k-mers are spelled in upper case whatever the case of the genome.
+    EXPECT_EQ(FindClumpIntervals("acgtACGTacgt", 4, 12, 3), Intervals({{"ACGT", 0, 12}}));
+
+    EXPECT_EQ(FindClumpIntervals("ACGT", 5, 4, 1), Intervals());
+    EXPECT_EQ(FindClumpIntervals("ACGT", 2, 5, 1), Intervals());
+    EXPECT_THROW(FindClumpIntervals(genome, 65, 80, 2), std::runtime_error);
+}
+
+TEST(TestFindClumpIntervals, MatchBruteForce) {
+    std::string text = random_sequence(200003);
+    std::string repeat = "ACGTTGCATGTCGCATGATGCATGAGAGCTTAGC";
+    // Clumps around the boundaries of the shards of a parallel scan.
+    for (size_t pos = 0; pos + 1000 < text.length(); pos += 16661) {
+        text.replace(pos, repeat.length(), repeat);
+        text.replace(pos + 450, repeat.length(), repeat);
+        text.replace(pos + 900, repeat.length(), repeat);
+    }
+    text[70000] = 'N';
+    std::transform(text.begin() + 100000, text.begin() + 150000, text.begin() + 100000, ::tolower);
+
+    for (int k : {5, 12, 20, 40}) {
+        auto serial = FindClumpIntervals(text, k, 1000, 3);
+        EXPECT_EQ(serial, brute_force_clump_intervals(text, k, 1000, 3));
+        for (int threads : {3, 8})
+            EXPECT_EQ(FindClumpIntervals(text, k, 1000, 3, threads), serial);
+
+        std::set<std::string> kmers;
+        for (const auto &clump : serial)
+            kmers.emplace(clump.kmer);
+        if (k <= 32) {
+            EXPECT_EQ(kmers, FindClumps(text, k, 1000, 3));
+        }
+    }
+}
+
 typedef std::set<std::string> (*FrequentWordsWithMismatchesFuncPtr)(std::string_view, int, int, bool rev);
 class TestFrequentWordsWithMismatches : public TestWithParam<FrequentWordsWithMismatchesFuncPtr> {};
 
@@ -394,6 +669,138 @@ INSTANTIATE_TEST_SUITE_P(
     }
 );
 
+TEST(TestFrequentWordsWithMismatchesByKmerCounter, MatchSorting) {
+    std::string text = random_sequence(3001);
+    // A repeat whose neighbors all share its count.
+    for (size_t pos : {100, 900, 1700, 2500})
+        text.replace(pos, 9, "ACGTTGCAT");
+
+    for (bool rev_comp : {false, true}) {
+        for (auto kd : {std::make_pair(4, 1), std::make_pair(9, 2), std::make_pair(14, 1)}) {
+            auto expected = FrequentWordsWithMismatchesBySorting(text, kd.first, kd.second, rev_comp);
+            EXPECT_EQ(FrequentWordsWithMismatchesByKmerCounter(text, kd.first, kd.second, rev_comp), expected);
+            EXPECT_EQ(FrequentWordsWithMismatchesByKmerCounter(text, kd.first, kd.second, rev_comp, 3), expected);
+        }
+    }
+
+    // Lower case and non-ACGT bytes.
+    EXPECT_EQ(
+        FrequentWordsWithMismatchesByKmerCounter("acgtNacgt", 4, 0),
+        std::set<std::string>({"ACGT"})
+    );
+    EXPECT_EQ(FrequentWordsWithMismatchesByKmerCounter("NNNN", 2, 1, true, 4), std::set<std::string>());
+}
+
+TEST(TestCanonicalKmers, MatchBothStrands) {
+    std::string text = random_sequence(301);
+    text.replace(100, 6, "ACGCGT");  // A palindrome.
+    text[200] = 'N';
+    const int k = 4;
+
+    std::vector<std::string> kmers;
+    for (size_t i = 0; i + k <= text.length(); i++) {
+        if (text.substr(i, k).find('N') == std::string::npos)
+            kmers.push_back(text.substr(i, k));
+    }
+
+    for (int d : {0, 1, 2}) {
+        // Counts with reverse complements, straight from the definition.
+        StrNumDict both_strands;
+        for (hash_t code = 0; code < (hash_t(1) << 2*k); code++) {
+            std::string pattern = NumberToPatternBitwise(code, k);
+            uint count = 0;
+            for (const auto &kmer : kmers) {
+                count += HammingDistance(pattern, kmer) <= static_cast<size_t>(d);
+                count += HammingDistance(pattern, ReverseComplement(kmer)) <= static_cast<size_t>(d);
+            }
+            if (count > 0)
+                both_strands[pattern] = count;
+        }
+
+        StrNumDict canonical;
+        for (const auto &p : both_strands) {
+            if (p.first <= ReverseComplement(p.first))
+                canonical.insert(p);
+        }
+
+        EXPECT_EQ(FrequencyTableWithMismatches(text, k, d, true), both_strands);
+        EXPECT_EQ(FrequencyTableWithMismatches(text, k, d, true, true), canonical);
+
+        if (d == 0) {
+            // Exact canonical counts follow the same convention, so a
+            // palindrome counts twice.
+            EXPECT_EQ(FrequencyTable(text, k, 1, true), canonical);
+            EXPECT_EQ(FrequencyTable(text, k, 3, true), canonical);
+
+            auto array = FrequencyArray(text, k, 2, true);
+            ASSERT_EQ(array.size(), hash_t(1) << 2*k);
+            for (hash_t code = 0; code < array.size(); code++) {
+                auto kmer = NumberToPatternBitwise(code, k);
+                EXPECT_EQ(array[code], canonical.count(kmer) ? canonical[kmer] : 0);
+            }
+        }
+    }
+
+    EXPECT_THROW(FrequencyTableWithMismatches(text, k, 1, false, true), std::runtime_error);
+}
+
+TEST(TestCanonicalKmers, CountPalindromesTwice) {
+    // ACGT is its own reverse complement, AAAA and TTTT are a pair.
+    std::string text = "ACGTTTTT";
+    StrNumDict expected({{"ACGT", 2}, {"AACG", 1}, {"AAAC", 1}, {"AAAA", 2}});
+    EXPECT_EQ(FrequencyTable(text, 4, 1, true), expected);
+    EXPECT_EQ(FrequencyTableWithMismatches(text, 4, 0, true, true), expected);
+    EXPECT_EQ(FrequencyArray(text, 4, 1, true)[PatternToNumber("ACGT")], 2);
+    EXPECT_EQ(CountKmers(text, 4, 1, true).count(PatternToNumber("ACGT")), 2);
+}
+
+TEST(TestReverseComplement, HandleIUPAC) {
+    EXPECT_EQ(ReverseComplement("ATGATCAAG"), "CTTGATCAT");
+    EXPECT_EQ(ReverseComplement("acgtNRYKMBVDHSWU"), "AWSDHBVKMRYNacgt");
+    EXPECT_EQ(ReverseComplement("AcGRn-"), "-nYCgT");
+    EXPECT_EQ(ReverseComplement(""), "");
+    EXPECT_THROW(ReverseComplement(std::string(40, 'A') + "X"), UnknownNucleotideError);
+    EXPECT_THROW(ReverseComplement("ACGT\n"), UnknownNucleotideError);
+}
+
+TEST(TestReverseComplement, MatchScalar) {
+    const std::string alphabet = "ACGTACGTACGTacgtacgtNnRYKMBVDHSW-";
+    for (size_t len : {1, 15, 16, 17, 31, 32, 33, 100, 2 * 4096 + 5, 20000}) {
+        std::string seq = random_text(len, alphabet, len);
+        std::string expected(len, 'A');
+        for (size_t i = 0; i < len; i++)
+            expected[i] = Complement(seq[len - 1 - i]);
+
+        EXPECT_EQ(ReverseComplement(seq), expected);
+
+        std::string out(len, ' ');
+        ReverseComplement(seq, out.data());
+        EXPECT_EQ(out, expected);
+
+        std::string in_place(seq);
+        ReverseComplementInPlace(in_place);
+        EXPECT_EQ(in_place, expected);
+
+        for (size_t chunk_length : {1, 7, 4096}) {
+            std::string chunks;
+            ReverseComplementChunks(seq, [&chunks](const std::string_view chunk) {
+                chunks.append(chunk);
+            }, chunk_length);
+            EXPECT_EQ(chunks, expected);
+        }
+    }
+}
+
+TEST(TestReverseComplementCode, MatchStrings) {
+    for (int k : {1, 5, 31, 32}) {
+        std::string kmer = random_sequence(k, k);
+        EXPECT_EQ(
+            ReverseComplementCode(PatternToNumber(kmer), k),
+            PatternToNumber(ReverseComplement(kmer))
+        );
+    }
+}
+
 TEST(TestPatternIndex, HandleNormalInput) {
     EXPECT_EQ(
         PatternIndex("ATGATGAAAATG", "ATG"),
@@ -517,6 +924,36 @@ TEST(TestPatternIndex, LongSequence) {
     );
 }
 
+TEST(TestExactMatcher, MatchBruteForce) {
+    // A low-entropy text, so that filters and q-gram shifts see many
+    // near misses.
+    std::string text = random_sequence(5000, 3);
+    for (size_t i = 0; i < 1000; i++)
+        text[i] = "AC"[text[i] == 'A' || text[i] == 'G'];
+    text.replace(2000, 4, "NNac");
+
+    for (size_t len : {1, 2, 3, 15, 16, 17, 31, 32, 33, 64, 100, 300}) {
+        for (size_t start : {size_t(0), size_t(500), size_t(1998), size_t(3000), 5000 - len}) {
+            std::string pattern = text.substr(start, len);
+            std::vector<size_t> expected;
+            for (size_t i = 0; i + len <= text.length(); i++) {
+                if (text.compare(i, len, pattern) == 0)
+                    expected.push_back(i);
+            }
+
+            EXPECT_EQ(PatternIndex(text, pattern), expected) << len << " " << start;
+            EXPECT_EQ(PatternCountByMatcher(text, pattern), expected.size());
+            EXPECT_EQ(ExactMatcher(pattern).find(text, expected.back()), expected.back());
+            EXPECT_EQ(ExactMatcher(pattern).find(text, expected.back() + 1), ExactMatcher::npos);
+        }
+    }
+
+    EXPECT_EQ(PatternIndex("ACGT", ""), std::vector<size_t>());
+    EXPECT_EQ(ExactMatcher("").find("ACGT"), ExactMatcher::npos);
+    EXPECT_EQ(ExactMatcher("ACGT").find("ACG"), ExactMatcher::npos);
+    EXPECT_EQ(ExactMatcher("ACGT").find("ACGTACGT", 9), ExactMatcher::npos);
+}
+
 TEST(TestPatternIndex, DonotReverseComplements) {
     // This dataset checks if your code is written correctly but is also taking into account
     // reverse complements, which we are not yet doing. Even though the reverse complement of
@@ -626,6 +1063,35 @@ TEST(TestFrequencyTable, NormalInput) {
     );
 }
 
+TEST(TestFrequencyTable, HandleMixedCase) {
+    EXPECT_EQ(
+        FrequencyTable("acgtACGT", 4),
+        StrNumDict({{"ACGT", 2}, {"CGTA", 1}, {"GTAC", 1}, {"TACG", 1}})
+    );
+
+    // Every counting backend spells k-mers in upper case, up to the
+    // 128-bit codes of KmerTable128. FrequentWordsSlow() alone matches
+    // k-mers by their exact spelling.
+    std::string repeat = "acgtTGCAtgcaACGTacgtTGCAtgcaACGTacgtTGCAtg";
+    std::string text = repeat + "TT" + repeat + "CC" + repeat;
+    std::string upper = text;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    for (int k : {4, 10, 40}) {
+        auto expected = FrequentWords(upper, k, AlgorithmEfficiency::Slow);
+        for (auto algo : {AlgorithmEfficiency::Default, AlgorithmEfficiency::Fast,
+                          AlgorithmEfficiency::Faster, AlgorithmEfficiency::Fastest}) {
+            // The array and the sorted codes are for short k-mers only.
+            if (k > 12 && (algo == AlgorithmEfficiency::Fast || algo == AlgorithmEfficiency::Faster))
+                continue;
+            EXPECT_EQ(FrequentWords(text, k, algo), expected) << k;
+        }
+
+        EXPECT_EQ(TopFrequentWords(text, k, 3), TopFrequentWords(upper, k, 3)) << k;
+        EXPECT_EQ(FrequentWordsAtLeast(text, k, 2), FrequentWordsAtLeast(upper, k, 2)) << k;
+        EXPECT_EQ(FrequencyTable(text, k), FrequencyTable(upper, k)) << k;
+    }
+}
+
 TEST(TestFrequencyArray, NormalInput) {
     EXPECT_EQ(
         FrequencyArray("ACGCGGCTCTGAAA", 2),
@@ -1041,9 +1507,22 @@ TEST_P(TestFindClumps, NormalInput) {
     );
 }
 
+TEST_P(TestFindClumps, HandleMixedCase) {
+    EXPECT_EQ(
+        FindClumps("acgtACGTacgtTTacGT", 4, 18, 3, GetParam()),
+        std::set<std::string>({"ACGT", "TACG"})
+    );
+
+    EXPECT_EQ(
+        FindClumps("ggATccGGatCCggAT", 2, 16, 3, GetParam()),
+        std::set<std::string>({"AT", "GA", "GG"})
+    );
+}
+
 INSTANTIATE_TEST_SUITE_P(
     TestAllFindClumps, TestFindClumps,
     Values(
+        AlgorithmEfficiency::Default,
         AlgorithmEfficiency::Slow,
         AlgorithmEfficiency::Fast,
         AlgorithmEfficiency::Faster,
@@ -1112,6 +1591,66 @@ TEST(TestFindMinimumSkew, NormalInput) {
     );
 }
 
+TEST(TestSkewScanner, MatchNaiveSkew) {
+    // A random walk with a deep valley, whose floor is a run of minima, so
+    // that both the skipped blocks and the base by base walk are exercised.
+    std::string genome = random_sequence(100003);
+    genome.replace(50000, 2000, std::string(2000, 'c'));
+    genome.replace(52000, 200, std::string(200, 'A'));
+    genome.replace(52200, 2000, std::string(2000, 'G'));
+    genome[60000] = 'N';
+
+    int64_t skew = 0, minimum = 0;
+    std::vector<int64_t> naive(1, 0);
+    for (char c : genome) {
+        skew += (c == 'G' || c == 'g') - (c == 'C' || c == 'c');
+        naive.push_back(skew);
+        minimum = std::min(minimum, skew);
+    }
+
+    std::vector<size_t> minima;
+    for (size_t i = 0; i < naive.size(); i++) {
+        if (naive[i] == minimum) minima.push_back(i);
+    }
+    ASSERT_GE(minima.size(), 200);
+    EXPECT_EQ(FindMinimumSkew(genome), minima);
+
+    // Fed in uneven chunks, with a track.
+    SkewScanner scanner(1000);
+    for (size_t i = 0, chunk = 1; i < genome.length(); i += chunk, chunk = chunk * 3 % 4099 + 1)
+        scanner.feed(std::string_view(genome).substr(i, chunk));
+
+    EXPECT_EQ(scanner.length(), genome.length());
+    EXPECT_EQ(scanner.skew(), skew);
+    EXPECT_EQ(scanner.minimum(), minimum);
+    EXPECT_EQ(scanner.minima(), minima);
+    ASSERT_EQ(scanner.track().size(), genome.length() / 1000 + 1);
+    for (const auto &point : scanner.track())
+        EXPECT_EQ(point.skew, naive[point.position]);
+
+    scanner.reset();
+    scanner.feed("CCGGCCGG");
+    EXPECT_EQ(scanner.minima(), std::vector<size_t>({2, 6}));
+    EXPECT_EQ(scanner.track(), std::vector<SkewPoint>({{0, 0}}));
+    EXPECT_EQ(SkewScanner().minima(), std::vector<size_t>({0}));
+}
+
+TEST(TestSkewScanner, ParallelMatchSerial) {
+    std::string genome = random_sequence(5000011);
+    EXPECT_EQ(FindMinimumSkew(genome, 4), FindMinimumSkew(genome));
+
+    // Minima spread over every chunk, some of them at chunk boundaries.
+    std::string flat(5000000, 'A');
+    for (size_t i = 0; i < flat.length(); i += 1000)
+        flat[i] = 'G';
+    for (size_t i = 1; i < flat.length(); i += 1000)
+        flat[i] = 'C';
+    EXPECT_EQ(FindMinimumSkew(flat, 8), FindMinimumSkew(flat));
+    EXPECT_EQ(FindMinimumSkew(flat, 3).size(), flat.length() - flat.length() / 1000 + 1);
+
+    EXPECT_EQ(FindMinimumSkew("CCGGCCGG", 4), std::vector<size_t>({2, 6}));
+}
+
 TEST(TestHammingDistance, NormalInput) {
     EXPECT_EQ(
         HammingDistance("GGGCCGTTGGT", "GGACCGTTGAC"),
@@ -1177,6 +1716,116 @@ TEST(TestHammingDistance, NormalInput) {
     );
 }
 
+TEST(TestHammingDistance, MatchScalar) {
+    std::string a = random_sequence(300, 1);
+    std::string b = random_sequence(300, 2);
+
+    // Lengths around the vector widths, and every limit.
+    for (size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 300}) {
+        size_t expected = 0;
+        for (size_t i = 0; i < n; i++)
+            expected += a[i] != b[i];
+
+        EXPECT_EQ(HammingDistance(std::string_view(a).substr(0, n), std::string_view(b).substr(0, n)), expected);
+        for (size_t limit = 0; limit <= expected + 1; limit++) {
+            size_t d = CountMismatches(a.data(), b.data(), n, limit);
+            if (expected <= limit) {
+                EXPECT_EQ(d, expected);
+            } else {
+                EXPECT_GT(d, limit);
+            }
+        }
+    }
+
+    EXPECT_THROW(HammingDistance("ACG", "AC"), std::runtime_error);
+}
+
+TEST(TestPatternIndexApproximate, MatchBruteForce) {
+    std::string text = random_sequence(3000, 7);
+    text[100] = 'N';
+    text[1500] = 'a';
+    text[2000] = '-';
+
+    for (size_t len : {1, 5, 20, 32, 33, 45, 64, 70}) {
+        for (size_t start : {90, 1490, 1995}) {
+            std::string pattern = text.substr(start, len);
+            for (auto &c : pattern) {
+                if (c == 'N' || c == 'a' || c == '-') c = 'C';
+            }
+
+            for (size_t d : {0, 1, 3, 8}) {
+                std::vector<size_t> expected;
+                for (size_t i = 0; i + len <= text.length(); i++) {
+                    size_t mismatches = 0;
+                    for (size_t j = 0; j < len; j++)
+                        mismatches += text[i + j] != pattern[j];
+                    if (mismatches <= d)
+                        expected.push_back(i);
+                }
+
+                EXPECT_EQ(PatternIndexApproximate(text, pattern, d), expected);
+            }
+        }
+    }
+
+    // Bytes other than upper case ACGT only match themselves.
+    EXPECT_EQ(PatternIndexApproximate("ACNTacgt", "acg", 0), std::vector<size_t>({4}));
+    EXPECT_EQ(PatternIndexApproximate("ACNTacgt", "ACG", 1), std::vector<size_t>({0}));
+    EXPECT_EQ(PatternIndexApproximate("ACG", "ACGT", 1), std::vector<size_t>());
+}
+
+static std::vector<size_t> brute_force_edit_index(
+    const std::string_view text, const std::string_view pattern, const size_t d)
+{
+    // Semi-global dynamic programming, one column per text position.
+    std::vector<size_t> column(pattern.length() + 1), output;
+    for (size_t i = 0; i <= pattern.length(); i++)
+        column[i] = i;
+
+    for (size_t j = 0; j < text.length(); j++) {
+        size_t diagonal = column[0];
+        column[0] = 0;
+        for (size_t i = 1; i <= pattern.length(); i++) {
+            size_t up = column[i];
+            column[i] = std::min({column[i] + 1, column[i - 1] + 1, diagonal + (pattern[i - 1] != text[j])});
+            diagonal = up;
+        }
+
+        if (column[pattern.length()] <= d)
+            output.push_back(j);
+    }
+
+    return output;
+}
+
+TEST(TestPatternIndexEditDistance, MatchBruteForce) {
+    std::string text = random_sequence(400, 11);
+    std::string long_text = random_sequence(1500, 12);
+
+    for (size_t len : {1, 7, 30, 64, 65, 130}) {
+        std::string pattern = long_text.substr(700, len);
+        // Plant an occurrence with a substitution, an insertion and a deletion.
+        std::string planted = pattern;
+        planted[len / 2] = planted[len / 2] == 'A' ? 'C' : 'A';
+        planted.insert(len / 3, "G");
+        if (len > 2) planted.erase(2 * len / 3, 1);
+        std::string genome = text + planted + text;
+
+        for (size_t d : {0, 1, 3, 10}) {
+            EXPECT_EQ(PatternIndexEditDistance(genome, pattern, d), brute_force_edit_index(genome, pattern, d));
+        }
+
+        for (size_t d : {0, 2, 5})
+            EXPECT_EQ(PatternIndexApproximateShiftAnd(genome, pattern, d), PatternIndexApproximate(genome, pattern, d));
+    }
+
+    EXPECT_EQ(PatternIndexEditDistance("GGACGTAGG", "ACGT", 0), std::vector<size_t>({5}));
+    EXPECT_EQ(PatternIndexEditDistance("GGACTAGG", "ACGT", 1), std::vector<size_t>({4}));
+    EXPECT_EQ(PatternIndexEditDistance("AC", "ACGT", 2), std::vector<size_t>({1}));
+    EXPECT_EQ(PatternIndexEditDistance("", "ACGT", 2), std::vector<size_t>());
+    EXPECT_EQ(PatternIndexApproximateShiftAnd("ACNTacgt", "acg", 0), std::vector<size_t>({4}));
+}
+
 TEST(TestPatternIndexApproximate, NormalInput) {
     EXPECT_EQ(
         PatternIndexApproximate(
@@ -1325,4 +1974,34 @@ TEST(TestNeighbors, NormalInput) {
     );
 }
 
+TEST(TestNeighbors, PackedMatchBruteForce) {
+    const int k = 6;
+    for (std::string pattern : {"ACGTTG", "AAAAAA", "TGCATG"}) {
+        hash_t code = PatternToNumber(pattern);
+        for (int d : {0, 1, 2, 3, 6, 7}) {
+            std::vector<hash_t> brute_force;
+            for (hash_t other = 0; other < (hash_t(1) << 2*k); other++) {
+                if (HammingDistance(pattern, NumberToPatternBitwise(other, k)) <= static_cast<size_t>(d))
+                    brute_force.push_back(other);
+            }
+
+            std::vector<hash_t> codes;
+            Neighbors(code, k, d, codes);
+            EXPECT_EQ(codes.size(), NeighborCount(k, d));
+            std::sort(codes.begin(), codes.end());
+            EXPECT_EQ(codes, brute_force);
+
+            std::set<std::string> strings;
+            for (auto other : brute_force)
+                strings.insert(NumberToPatternBitwise(other, k));
+            EXPECT_EQ(NeighborsRecursive(pattern, d), strings);
+        }
+    }
+
+    // Only upper case ACGT patterns are packed, others keep their letters.
+    EXPECT_EQ(NeighborsRecursive("acg", 0), std::set<std::string>({"acg"}));
+    EXPECT_EQ(ImmediateNeighbors("AN").size(), 8);
+    EXPECT_EQ(NeighborCount(32, 2), 1 + 32 * 3 + 496 * 9);
+}
+
 } // namespace
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "sketch.h"
+#include "counter.h"
+#include "pattern.h"
+#include "revcomp.h"
+
+#include "testutils.h"
+
+namespace {
+
+using namespace bioutils::algorithms;
+
+TEST(TestCountMinSketch, BoundTheError) {
+    std::string text = random_text(200000, "ACGT");
+    KmerCounter exact = CountKmers(text, 12);
+
+    CountMinSketch sketch = CountMinSketch::withError(1e-4, 0.01);
+    EXPECT_EQ(sketch.width(), 32768);
+    EXPECT_EQ(sketch.depth(), 5);
+    ForEachKmer(text, 12, [&sketch](const size_t, const RollingKmer &kmer) { sketch.add(kmer.forward()); });
+
+    // Never below the true count, and rarely more than epsilon * N above.
+    size_t n = text.length() - 11, above = 0, keys = 0;
+    exact.forEach([&](const hash_t code, const uint count) {
+        uint estimate = sketch.estimate(code);
+        EXPECT_GE(estimate, count);
+        if (estimate > count + 1e-4 * n)
+            above++;
+        keys++;
+    });
+    EXPECT_LE(above, keys / 100);
+
+    CountMinSketch doubled = sketch;
+    doubled.merge(sketch);
+    EXPECT_EQ(doubled.estimate(PatternToNumber(text.substr(0, 12))),
+              2 * sketch.estimate(PatternToNumber(text.substr(0, 12))));
+    EXPECT_THROW(doubled.merge(CountMinSketch(16, 5)), std::runtime_error);
+    EXPECT_THROW(CountMinSketch::withError(0, 0.01), std::runtime_error);
+}
+
+TEST(TestHyperLogLog, EstimateCardinality) {
+    for (size_t n : {0, 10, 1000, 50000, 1000000}) {
+        HyperLogLog hll;
+        for (hash_t key = 0; key < n; key++) {
+            hll.add(key);
+            hll.add(key);
+        }
+        EXPECT_NEAR(hll.estimate(), n, 4 * hll.standardError() * n + 1) << n;
+    }
+
+    HyperLogLog a(10), b(10);
+    for (hash_t key = 0; key < 20000; key++)
+        (key % 2 ? a : b).add(key);
+    a.merge(b);
+    EXPECT_NEAR(a.estimate(), 20000, 4 * a.standardError() * 20000);
+    EXPECT_THROW(a.merge(HyperLogLog(12)), std::runtime_error);
+    EXPECT_THROW(HyperLogLog(3), std::runtime_error);
+}
+
+TEST(TestKmerSketch, MatchExactCounts) {
+    std::string repeat = "GATTACAGATTACATTTGACCA";
+    std::vector<std::string> reads;
+    for (unsigned int i = 0; i < 2000; i++) {
+        std::string read = random_text(100, "ACGTN", i + 1);
+        if (i % 10 == 0)
+            read.replace(30, repeat.length(), repeat);
+        reads.push_back(read);
+    }
+
+    for (bool canonical : {false, true}) {
+        KmerSketch sketch(15, 5, 1e-4, 0.01, 14, canonical);
+        std::unordered_set<hash_t> distinct;
+        uint64_t total = 0;
+        for (const auto &read : reads) {
+            sketch.add(read);
+            ForEachKmer(read, 15, [&](const size_t, const RollingKmer &kmer) {
+                distinct.insert(canonical ? kmer.canonical() : kmer.forward());
+                total++;
+            });
+        }
+
+        EXPECT_EQ(sketch.total(), total);
+        EXPECT_NEAR(sketch.distinct(), distinct.size(), 4 * 0.0082 * distinct.size());
+
+        // The repeat holds the 8 k-mers counted 200 times, the others are
+        // counted a few times at most.
+        auto top = sketch.top();
+        ASSERT_EQ(top.size(), 5);
+        for (const auto &p : top) {
+            bool found = repeat.find(p.first) != std::string::npos
+                || (canonical && repeat.find(ReverseComplement(p.first)) != std::string::npos);
+            EXPECT_TRUE(found) << p.first;
+            EXPECT_GE(p.second, 200);
+            EXPECT_LE(p.second, 200 + 1e-4 * total);
+        }
+        EXPECT_GE(sketch.estimate(repeat.substr(0, 15)), 200);
+        EXPECT_EQ(sketch.estimate(repeat.substr(0, 15)), sketch.estimate(
+            canonical ? ReverseComplement(repeat.substr(0, 15)) : repeat.substr(0, 15)));
+        EXPECT_EQ(sketch.estimate("NNNNNNNNNNNNNNN"), 0);
+    }
+
+    EXPECT_THROW(KmerSketch(33), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,24 @@
+#ifndef TESTS_TESTUTILS_H
+#define TESTS_TESTUTILS_H
+
+#include <string>
+
+// Deterministic pseudo-random text over \a alphabet, so failures are
+// reproducible.
+inline std::string random_text(const size_t length, const std::string &alphabet, unsigned int seed = 42)
+{
+    std::string text(length, ' ');
+    for (auto &c : text) {
+        seed = seed * 1103515245 + 12345;
+        c = alphabet[(seed >> 16) % alphabet.length()];
+    }
+    return text;
+}
+
+// Deterministic pseudo-random DNA of upper case ACGT.
+inline std::string random_sequence(const size_t length, unsigned int seed = 42)
+{
+    return random_text(length, "ACGT", seed);
+}
+
+#endif // TESTS_TESTUTILS_H